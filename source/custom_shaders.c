@@ -25,6 +25,7 @@
 
 #define MAX_CUSTOM_SHADERS 2048 // Maximum number of linkable custom shaders
 #define MAX_CUSTOM_PROGRAMS 1024 // Maximum number of linkable custom programs
+#define DRAW_QUEUE_MIN_SIZE 64 // Initial capacity of the baked objects draws queue
 
 #define disableDrawAttrib(i) \
 	orig_stride[i] = streams[i].stride; \
@@ -37,6 +38,7 @@
 
 // Internal stuffs
 GLboolean is_shark_online = GL_FALSE; // Current vitaShaRK status
+static const void *objects_streams[VERTEX_ATTRIBS_NUM]; // Vertex streams set for the vgl* draw pipeline
 static SceGxmVertexAttribute temp_attributes[VERTEX_ATTRIBS_NUM];
 static SceGxmVertexStream temp_streams[VERTEX_ATTRIBS_NUM];
 static unsigned short orig_stride[VERTEX_ATTRIBS_NUM];
@@ -109,9 +111,63 @@ typedef struct {
 	GLboolean is_fbo_float;
 } program;
 
+// Baked objects struct holding precomputed sceGxm state for vglDrawObjects
+typedef struct {
+	SceGxmPrecomputedDraw draw;
+	SceGxmPrecomputedVertexState vert_state;
+	SceGxmPrecomputedFragmentState frag_state;
+	void *draw_data; // Extra data for the precomputed draw
+	void *vert_data; // Extra data for the precomputed vertex state
+	void *frag_data; // Extra data for the precomputed fragment state
+	void *vert_unifs; // Baked vertex default uniform buffer
+	void *frag_unifs; // Baked fragment default uniform buffer
+	GLuint prog; // Program the objects got baked with
+	shader *vshader; // Vertex shader of the program the objects got baked with
+	shader *fshader; // Fragment shader of the program the objects got baked with
+	SceGxmVertexProgram *vprog; // Vertex program the precomputed vertex state refers to
+	SceGxmFragmentProgram *fprog; // Fragment program the precomputed fragment state refers to
+	SceGxmTexture textures[TEXTURE_IMAGE_UNITS_NUM]; // Textures the precomputed fragment state refers to
+	GLenum mode; // Primitive type used for the draw
+	GLsizei count; // Number of indices used for the draw
+	void *next; // Next alive baked objects
+	GLboolean queued; // Whether the objects are referenced by the draws queue
+} baked_objects;
+
+// Queued draw struct for the baked objects draws queue
+typedef struct {
+	baked_objects *objects; // Baked objects to draw
+	uint64_t key; // Sort key
+	uint32_t seq; // Submission order
+	SceGxmPrimitiveType gxm_p; // Primitive type used for the draw
+	GLboolean is_blended; // Whether blending was enabled when the draw got queued
+	GLboolean depth_test; // Depth test state when the draw got queued
+	GLboolean depth_mask; // Depth mask state when the draw got queued
+	SceGxmDepthFunc depth_func; // Depth function when the draw got queued
+} queued_draw;
+
+static queued_draw *draw_queue = NULL; // Queue of draws waiting to be sorted
+static uint32_t draw_queue_num = 0; // Number of queued draws
+static uint32_t draw_queue_size = 0; // Capacity of the draws queue
+static GLboolean draw_queue_enabled = GL_FALSE; // Whether baked objects draws get queued
+static SceGxmVertexProgram *issued_vprog = NULL; // Vertex program set by the last issued baked objects draw
+static SceGxmFragmentProgram *issued_fprog = NULL; // Fragment program set by the last issued baked objects draw
+static SceGxmPrecomputedVertexState *issued_vert_state = NULL; // Precomputed vertex state set by the last issued baked objects draw
+static SceGxmPrecomputedFragmentState *issued_frag_state = NULL; // Precomputed fragment state set by the last issued baked objects draw
+
 // Internal shaders and array
 static shader shaders[MAX_CUSTOM_SHADERS];
 static program progs[MAX_CUSTOM_PROGRAMS];
+static baked_objects *baked_list = NULL; // Alive baked objects, holding references to their patched programs
+
+// Counts the references to a patched fragment program held by baked objects
+static unsigned int get_baked_fragment_refs(SceGxmFragmentProgram *fprog) {
+	unsigned int refs = 0;
+	for (baked_objects *b = baked_list; b; b = (baked_objects *)b->next) {
+		if (b->fprog == fprog)
+			refs++;
+	}
+	return refs;
+}
 
 void release_shader(shader *s) {
 	// Deallocating shader and unregistering it from sceGxmShaderPatcher
@@ -234,6 +290,67 @@ void resetCustomShaders(void) {
 	}
 }
 
+static inline uint32_t attrib_size_in_bytes(SceGxmVertexAttribute *attr) {
+	switch (attr->format) {
+	case SCE_GXM_ATTRIBUTE_FORMAT_F32:
+		return attr->componentCount * 4;
+	case SCE_GXM_ATTRIBUTE_FORMAT_F16:
+	case SCE_GXM_ATTRIBUTE_FORMAT_S16:
+	case SCE_GXM_ATTRIBUTE_FORMAT_S16N:
+	case SCE_GXM_ATTRIBUTE_FORMAT_U16:
+	case SCE_GXM_ATTRIBUTE_FORMAT_U16N:
+		return attr->componentCount * 2;
+	default:
+		return attr->componentCount;
+	}
+}
+
+// Groups enabled client attributes sharing stride and vertex record so that each group is uploaded with a single copy
+static void group_interleaved_attribs(program *p, SceGxmVertexAttribute *attributes, SceGxmVertexStream *streams, uint8_t *leaders, uint32_t *bases) {
+	uint32_t ends[VERTEX_ATTRIBS_NUM];
+	for (int i = 0; i < p->attr_num; i++) {
+		leaders[i] = i;
+		if (!(cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) || cur_vao->vertex_attrib_vbo[p->attr_map[i]])
+			continue;
+		uint32_t start = cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+		uint32_t end = start + attrib_size_in_bytes(&attributes[i]);
+		bases[i] = start;
+		ends[i] = end;
+
+		// Joining the first group whose vertex record can hold this attribute too
+		for (int j = 0; j < i; j++) {
+			if (leaders[j] != j || streams[j].stride != streams[i].stride || !(cur_vao->vertex_attrib_state & (1 << p->attr_map[j])) || cur_vao->vertex_attrib_vbo[p->attr_map[j]])
+				continue;
+			uint32_t group_start = min(bases[j], start);
+			uint32_t group_end = max(ends[j], end);
+			if (group_end - group_start <= streams[i].stride) {
+				leaders[i] = j;
+				bases[j] = group_start;
+				ends[j] = group_end;
+				break;
+			}
+		}
+	}
+}
+
+// Assigns a sceGxm stream to every attribute with interleaved attributes groups sharing their leader stream, returns the number of streams
+static int pack_attrib_streams(program *p, SceGxmVertexAttribute *attributes, SceGxmVertexStream *streams, uint8_t *leaders, void **ptrs, SceGxmVertexStream *packed_streams, const void **packed_ptrs) {
+	int streams_num = 0;
+	for (int i = 0; i < p->attr_num; i++) {
+		int leader = leaders ? leaders[i] : i;
+		if (leader == i) {
+			vgl_fast_memcpy(&packed_streams[streams_num], &streams[i], sizeof(SceGxmVertexStream));
+			if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i]))
+				packed_ptrs[streams_num] = ptrs[i];
+			else
+				packed_ptrs[streams_num] = cur_vao->vertex_attrib_value[p->attr_map[i]];
+			attributes[i].streamIndex = streams_num++;
+		} else
+			attributes[i].streamIndex = attributes[leader].streamIndex;
+	}
+	return streams_num;
+}
+
 GLboolean _glDrawArrays_CustomShadersIMPL(GLsizei count) {
 	program *p = &progs[cur_program - 1];
 
@@ -252,13 +369,13 @@ GLboolean _glDrawArrays_CustomShadersIMPL(GLsizei count) {
 #endif
 			texture_unit *tex_unit = &texture_units[(int)p->frag_texunits[i]->data];
 #ifndef SKIP_ERROR_HANDLING
-			int r = sceGxmTextureValidate(&texture_slots[tex_unit->tex_id].gxm_tex);
+			int r = sceGxmTextureValidate(&getTexture(tex_unit->tex_id)->gxm_tex);
 			if (r) {
 				vgl_log("%s:%d glDrawArrays: Fragment texture on TEXUNIT%d is invalid (%s), draw will be skipped.\n", __FILE__, __LINE__, i, get_gxm_error_literal(r));
 				return GL_FALSE;
 			}
 #endif
-			sceGxmSetFragmentTexture(gxm_context, i, &texture_slots[tex_unit->tex_id].gxm_tex);
+			setFragmentTexture(i, getTexture(tex_unit->tex_id));
 #ifndef SAMPLERS_SPEEDHACK		
 		}
 #endif
@@ -271,13 +388,14 @@ GLboolean _glDrawArrays_CustomShadersIMPL(GLsizei count) {
 #endif
 			texture_unit *tex_unit = &texture_units[(int)p->vert_texunits[i]->data];
 #ifndef SKIP_ERROR_HANDLING
-			int r = sceGxmTextureValidate(&texture_slots[tex_unit->tex_id].gxm_tex);
+			int r = sceGxmTextureValidate(&getTexture(tex_unit->tex_id)->gxm_tex);
 			if (r) {
 				vgl_log("%s:%d glDrawArrays: Vertex texture on TEXUNIT%d is invalid (%s), draw will be skipped.\n", __FILE__, __LINE__, i, get_gxm_error_literal(r));
 				return GL_FALSE;
 			}
 #endif
-			sceGxmSetVertexTexture(gxm_context, i, &texture_slots[tex_unit->tex_id].gxm_tex);
+			waitTextureUpload(getTexture(tex_unit->tex_id));
+			sceGxmSetVertexTexture(gxm_context, i, &getTexture(tex_unit->tex_id)->gxm_tex);
 #ifndef SAMPLERS_SPEEDHACK		
 		}
 #endif
@@ -301,58 +419,50 @@ GLboolean _glDrawArrays_CustomShadersIMPL(GLsizei count) {
 
 	void *ptrs[VERTEX_ATTRIBS_NUM];
 #ifndef DRAW_SPEEDHACK
-	GLboolean is_packed = p->attr_num > 1;
-	if (is_packed) {
-		for (int i = 0; i < p->attr_num; i++) {
-			if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
-				is_packed = GL_FALSE;
-				break;
-			}
-		}
-		if (is_packed && (!(cur_vao->vertex_attrib_offsets[p->attr_map[0]] + streams[0].stride > cur_vao->vertex_attrib_offsets[p->attr_map[1]] && cur_vao->vertex_attrib_offsets[p->attr_map[1]] > cur_vao->vertex_attrib_offsets[p->attr_map[0]])))
-			is_packed = GL_FALSE;
-	}
+	uint8_t leaders[VERTEX_ATTRIBS_NUM];
+	uint32_t bases[VERTEX_ATTRIBS_NUM];
+	group_interleaved_attribs(p, attributes, streams, leaders, bases);
+#endif
 
 	// Gathering real attribute data pointers
-	if (is_packed) {
-		ptrs[0] = gpu_alloc_mapped_temp(count * streams[0].stride);
-		vgl_fast_memcpy(ptrs[0], (void *)cur_vao->vertex_attrib_offsets[p->attr_map[0]], count * streams[0].stride);
-		for (int i = 0; i < p->attr_num; i++) {
-			attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
-			if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
-				attributes[i].offset = cur_vao->vertex_attrib_offsets[p->attr_map[i]] - cur_vao->vertex_attrib_offsets[p->attr_map[0]];
+	for (int i = 0; i < p->attr_num; i++) {
+		attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
+		if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
+			if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
+				gpubuffer *gpu_buf = (gpubuffer *)cur_vao->vertex_attrib_vbo[p->attr_map[i]];
+				ptrs[i] = (uint8_t *)gpu_buf->ptr + cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				markBufferAsUsed(gpu_buf)
+				attributes[i].offset = 0;
 			} else {
-				disableDrawAttrib(i)
-			}
-		}
-	} else
-#endif
-	{
-		for (int i = 0; i < p->attr_num; i++) {
-			attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
-			if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
-				if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
-					gpubuffer *gpu_buf = (gpubuffer *)cur_vao->vertex_attrib_vbo[p->attr_map[i]];
-					ptrs[i] = (uint8_t *)gpu_buf->ptr + cur_vao->vertex_attrib_offsets[p->attr_map[i]];
-					gpu_buf->used = GL_TRUE;
-					attributes[i].offset = 0;
-				} else {
 #ifdef DRAW_SPEEDHACK
-					ptrs[i] = (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				ptrs[i] = (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				attributes[i].offset = 0;
 #else
-					ptrs[i] = gpu_alloc_mapped_temp(count * streams[i].stride);
-					vgl_fast_memcpy(ptrs[i], (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]], count * streams[i].stride);
+				// Interleaved attributes share a single copy made by their group leader
+				uint8_t leader = leaders[i];
+				if (leader == i)
+					ptrs[i] = upload_client_array((void *)bases[i], count * streams[i].stride);
+				else
+					ptrs[i] = ptrs[leader];
+				attributes[i].offset = cur_vao->vertex_attrib_offsets[p->attr_map[i]] - bases[leader];
 #endif
-					attributes[i].offset = 0;
-				}
-			} else {
-				disableDrawAttrib(i)
 			}
+		} else {
+			disableDrawAttrib(i)
 		}
 	}
 
+	// Packing vertex streams so that interleaved attributes groups are fed through a single stream
+	SceGxmVertexStream packed_streams[VERTEX_ATTRIBS_NUM];
+	const void *packed_ptrs[VERTEX_ATTRIBS_NUM];
+#ifdef DRAW_SPEEDHACK
+	int streams_num = pack_attrib_streams(p, attributes, streams, NULL, ptrs, packed_streams, packed_ptrs);
+#else
+	int streams_num = pack_attrib_streams(p, attributes, streams, leaders, ptrs, packed_streams, packed_ptrs);
+#endif
+
 	// Uploading new vertex program
-	patchVertexProgram(gxm_shader_patcher, p->vshader->id, attributes, p->attr_num, streams, p->attr_num, &p->vprog);
+	patchVertexProgram(gxm_shader_patcher, p->vshader->id, attributes, p->attr_num, packed_streams, streams_num, &p->vprog);
 	sceGxmSetVertexProgram(gxm_context, p->vprog);
 
 	// Uploading both fragment and vertex uniforms data
@@ -385,19 +495,14 @@ GLboolean _glDrawArrays_CustomShadersIMPL(GLsizei count) {
 	}
 
 	// Uploading vertex streams
+	for (int i = 0; i < streams_num; i++) {
+		setVertexStream(i, packed_ptrs[i]);
+	}
 	for (int i = 0; i < p->attr_num; i++) {
 		GLboolean is_active = cur_vao->vertex_attrib_state & (1 << p->attr_map[i]);
-		if (is_active) {
-#ifdef DRAW_SPEEDHACK
-			sceGxmSetVertexStream(gxm_context, i, ptrs[i]);
-#else
-			sceGxmSetVertexStream(gxm_context, i, is_packed ? ptrs[0] : ptrs[i]);
-#endif
-		} else {
-			sceGxmSetVertexStream(gxm_context, i, cur_vao->vertex_attrib_value[p->attr_map[i]]);
-		}
 		if (!p->has_unaligned_attrs) {
 			attributes[i].regIndex = i;
+			attributes[i].streamIndex = i;
 			if (!is_active) {
 				streams[i].stride = orig_stride[i];
 				attributes[i].componentCount = orig_size[i];
@@ -427,13 +532,13 @@ GLboolean _glDrawElements_CustomShadersIMPL(uint16_t *idx_buf, GLsizei count, ui
 #endif
 			texture_unit *tex_unit = &texture_units[(int)p->frag_texunits[i]->data];
 #ifndef SKIP_ERROR_HANDLING
-			int r = sceGxmTextureValidate(&texture_slots[tex_unit->tex_id].gxm_tex);
+			int r = sceGxmTextureValidate(&getTexture(tex_unit->tex_id)->gxm_tex);
 			if (r) {
 				vgl_log("%s:%d glDrawElements: Fragment texture on TEXUNIT%d is invalid (%s), draw will be skipped.\n", __FILE__, __LINE__, i, get_gxm_error_literal(r));
 				return GL_FALSE;
 			}
 #endif
-			sceGxmSetFragmentTexture(gxm_context, i, &texture_slots[tex_unit->tex_id].gxm_tex);
+			setFragmentTexture(i, getTexture(tex_unit->tex_id));
 #ifndef SAMPLERS_SPEEDHACK
 		}
 #endif
@@ -446,13 +551,14 @@ GLboolean _glDrawElements_CustomShadersIMPL(uint16_t *idx_buf, GLsizei count, ui
 #endif
 			texture_unit *tex_unit = &texture_units[(int)p->vert_texunits[i]->data];
 #ifndef SKIP_ERROR_HANDLING
-			int r = sceGxmTextureValidate(&texture_slots[tex_unit->tex_id].gxm_tex);
+			int r = sceGxmTextureValidate(&getTexture(tex_unit->tex_id)->gxm_tex);
 			if (r) {
 				vgl_log("%s:%d glDrawElements: Vertex texture on TEXUNIT%d is invalid (%s), draw will be skipped.\n", __FILE__, __LINE__, i, get_gxm_error_literal(r));
 				return GL_FALSE;
 			}
 #endif
-			sceGxmSetVertexTexture(gxm_context, i, &texture_slots[tex_unit->tex_id].gxm_tex);
+			waitTextureUpload(getTexture(tex_unit->tex_id));
+			sceGxmSetVertexTexture(gxm_context, i, &getTexture(tex_unit->tex_id)->gxm_tex);
 #ifndef SAMPLERS_SPEEDHACK		
 		}
 #endif
@@ -476,22 +582,18 @@ GLboolean _glDrawElements_CustomShadersIMPL(uint16_t *idx_buf, GLsizei count, ui
 
 	void *ptrs[VERTEX_ATTRIBS_NUM];
 #ifndef DRAW_SPEEDHACK
-	GLboolean is_packed = p->attr_num > 1;
-	GLboolean is_full_vbo = GL_TRUE;
-	if (is_packed) {
-		for (int i = 0; i < p->attr_num; i++) {
-			if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
-				is_packed = GL_FALSE;
-			} else {
-				is_full_vbo = GL_FALSE;
-			}
-		}
-		if (is_packed && (!(cur_vao->vertex_attrib_offsets[p->attr_map[0]] + streams[0].stride > cur_vao->vertex_attrib_offsets[p->attr_map[1]] && cur_vao->vertex_attrib_offsets[p->attr_map[1]] > cur_vao->vertex_attrib_offsets[p->attr_map[0]])))
-			is_packed = GL_FALSE;
-	} else if (!cur_vao->vertex_attrib_vbo[p->attr_map[0]])
-		is_full_vbo = GL_FALSE;
+	uint8_t leaders[VERTEX_ATTRIBS_NUM];
+	uint32_t bases[VERTEX_ATTRIBS_NUM];
+	group_interleaved_attribs(p, attributes, streams, leaders, bases);
 
 	// Detecting highest index value
+	GLboolean is_full_vbo = GL_TRUE;
+	for (int i = 0; i < p->attr_num; i++) {
+		if ((cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) && !cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
+			is_full_vbo = GL_FALSE;
+			break;
+		}
+	}
 	if (!is_full_vbo && !top_idx) {
 		if (is_short) {
 			for (int i = 0; i < count; i++) {
@@ -507,47 +609,47 @@ GLboolean _glDrawElements_CustomShadersIMPL(uint16_t *idx_buf, GLsizei count, ui
 		}
 		top_idx++;
 	}
+#endif
 
 	// Gathering real attribute data pointers
-	if (is_packed) {
-		ptrs[0] = gpu_alloc_mapped_temp(top_idx * streams[0].stride);
-		vgl_fast_memcpy(ptrs[0], (void *)cur_vao->vertex_attrib_offsets[p->attr_map[0]], top_idx * streams[0].stride);
-		for (int i = 0; i < p->attr_num; i++) {
-			attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
-			if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
-				attributes[i].offset = cur_vao->vertex_attrib_offsets[p->attr_map[i]] - cur_vao->vertex_attrib_offsets[p->attr_map[0]];
+	for (int i = 0; i < p->attr_num; i++) {
+		attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
+		if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
+			if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
+				gpubuffer *gpu_buf = (gpubuffer *)cur_vao->vertex_attrib_vbo[p->attr_map[i]];
+				ptrs[i] = (uint8_t *)gpu_buf->ptr + cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				markBufferAsUsed(gpu_buf)
+				attributes[i].offset = 0;
 			} else {
-				disableDrawAttrib(i)
-			}
-		}
-	} else
-#endif
-	{
-		for (int i = 0; i < p->attr_num; i++) {
-			attributes[i].regIndex = p->attr[p->attr_map[i]].regIndex;
-			if (cur_vao->vertex_attrib_state & (1 << p->attr_map[i])) {
-				if (cur_vao->vertex_attrib_vbo[p->attr_map[i]]) {
-					gpubuffer *gpu_buf = (gpubuffer *)cur_vao->vertex_attrib_vbo[p->attr_map[i]];
-					ptrs[i] = (uint8_t *)gpu_buf->ptr + cur_vao->vertex_attrib_offsets[p->attr_map[i]];
-					gpu_buf->used = GL_TRUE;
-					attributes[i].offset = 0;
-				} else {
 #ifdef DRAW_SPEEDHACK
-					ptrs[i] = (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				ptrs[i] = (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]];
+				attributes[i].offset = 0;
 #else
-					ptrs[i] = gpu_alloc_mapped_temp(top_idx * streams[i].stride);
-					vgl_fast_memcpy(ptrs[i], (void *)cur_vao->vertex_attrib_offsets[p->attr_map[i]], top_idx * streams[i].stride);
+				// Interleaved attributes share a single copy made by their group leader
+				uint8_t leader = leaders[i];
+				if (leader == i)
+					ptrs[i] = upload_client_array((void *)bases[i], top_idx * streams[i].stride);
+				else
+					ptrs[i] = ptrs[leader];
+				attributes[i].offset = cur_vao->vertex_attrib_offsets[p->attr_map[i]] - bases[leader];
 #endif
-					attributes[i].offset = 0;
-				}
-			} else {
-				disableDrawAttrib(i)
 			}
+		} else {
+			disableDrawAttrib(i)
 		}
 	}
 
+	// Packing vertex streams so that interleaved attributes groups are fed through a single stream
+	SceGxmVertexStream packed_streams[VERTEX_ATTRIBS_NUM];
+	const void *packed_ptrs[VERTEX_ATTRIBS_NUM];
+#ifdef DRAW_SPEEDHACK
+	int streams_num = pack_attrib_streams(p, attributes, streams, NULL, ptrs, packed_streams, packed_ptrs);
+#else
+	int streams_num = pack_attrib_streams(p, attributes, streams, leaders, ptrs, packed_streams, packed_ptrs);
+#endif
+
 	// Uploading new vertex program
-	patchVertexProgram(gxm_shader_patcher, p->vshader->id, attributes, p->attr_num, streams, p->attr_num, &p->vprog);
+	patchVertexProgram(gxm_shader_patcher, p->vshader->id, attributes, p->attr_num, packed_streams, streams_num, &p->vprog);
 	sceGxmSetVertexProgram(gxm_context, p->vprog);
 
 	// Uploading both fragment and vertex uniforms data
@@ -580,19 +682,14 @@ GLboolean _glDrawElements_CustomShadersIMPL(uint16_t *idx_buf, GLsizei count, ui
 	}
 
 	// Uploading vertex streams
+	for (int i = 0; i < streams_num; i++) {
+		setVertexStream(i, packed_ptrs[i]);
+	}
 	for (int i = 0; i < p->attr_num; i++) {
 		GLboolean is_active = cur_vao->vertex_attrib_state & (1 << p->attr_map[i]);
-		if (is_active) {
-#ifdef DRAW_SPEEDHACK
-			sceGxmSetVertexStream(gxm_context, i, ptrs[i]);
-#else
-			sceGxmSetVertexStream(gxm_context, i, is_packed ? ptrs[0] : ptrs[i]);
-#endif
-		} else {
-			sceGxmSetVertexStream(gxm_context, i, cur_vao->vertex_attrib_value[p->attr_map[i]]);
-		}
 		if (!p->has_unaligned_attrs) {
 			attributes[i].regIndex = i;
+			attributes[i].streamIndex = i;
 			if (!is_active) {
 				streams[i].stride = orig_stride[i];
 				attributes[i].componentCount = orig_size[i];
@@ -653,7 +750,7 @@ void _vglDrawObjects_CustomShadersIMPL(GLboolean implicit_wvp) {
 		if (p->frag_texunits[i]) {
 #endif
 			texture_unit *tex_unit = &texture_units[i];
-			sceGxmSetFragmentTexture(gxm_context, i, &texture_slots[tex_unit->tex_id].gxm_tex);
+			setFragmentTexture(i, getTexture(tex_unit->tex_id));
 #ifndef SAMPLERS_SPEEDHACK
 		}
 #endif
@@ -1095,6 +1192,9 @@ void glDeleteProgram(GLuint prog) {
 	if (p->status) {
 		unsigned int count, i;
 		sceGxmShaderPatcherGetFragmentProgramRefCount(gxm_shader_patcher, p->fprog, &count);
+		
+		// References held by baked objects get released by vglDeleteBakedObjects
+		count -= get_baked_fragment_refs(p->fprog);
 		for (i = 0; i < count; i++) {
 			sceGxmShaderPatcherReleaseFragmentProgram(gxm_shader_patcher, p->fprog);
 			sceGxmShaderPatcherReleaseVertexProgram(gxm_shader_patcher, p->vprog);
@@ -2214,12 +2314,387 @@ void vglVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean nor
 	}
 
 	// Setting vertex stream to passed index in sceGxm
-	sceGxmSetVertexStream(gxm_context, index, ptr);
+	setVertexStream(index, ptr);
+	objects_streams[index] = ptr;
 }
 
 void vglVertexAttribPointerMapped(GLuint index, const GLvoid *pointer) {
 	// Setting vertex stream to passed index in sceGxm
-	sceGxmSetVertexStream(gxm_context, index, pointer);
+	setVertexStream(index, pointer);
+	objects_streams[index] = pointer;
+}
+
+// Fills a default uniform buffer with the current values of a program uniforms
+static void *bake_uniforms(const SceGxmProgram *prog, uniform *u, const SceGxmProgramParameter *wvp, GLboolean implicit_wvp) {
+	uint32_t size = sceGxmProgramGetDefaultUniformBufferSize(prog);
+	if (!size)
+		return NULL;
+	void *buffer = gpu_alloc_mapped_aligned(MEM_ALIGNMENT, size, VGL_MEM_RAM);
+	if (!buffer)
+		return NULL;
+	while (u) {
+		if (wvp && u->ptr == wvp && implicit_wvp) {
+			if (mvp_modified) {
+				matrix4x4_multiply(mvp_matrix, projection_matrix, modelview_matrix);
+				mvp_modified = GL_FALSE;
+			}
+			sceGxmSetUniformDataF(buffer, wvp, 0, 16, (const float *)mvp_matrix);
+		} else if (u->size)
+			sceGxmSetUniformDataF(buffer, u->ptr, 0, u->size, u->data);
+		u = (uniform *)u->chain;
+	}
+	return buffer;
+}
+
+// Gets the texture bound to the texture unit a fragment sampler of a program refers to, NULL for unused samplers
+static inline texture *get_frag_sampler_texture(program *p, int i) {
+#ifndef SAMPLERS_SPEEDHACK
+	if (!p->frag_texunits[i])
+		return NULL;
+#endif
+	return getTexture(texture_units[(int)p->frag_texunits[i]->data].tex_id);
+}
+
+// (Re)builds the precomputed fragment state of baked objects for the current fragment program and textures
+static GLboolean bake_fragment_state(baked_objects *b, program *p) {
+	void *frag_data = gpu_alloc_mapped_aligned(SCE_GXM_PRECOMPUTED_ALIGNMENT, sceGxmPrecomputedFragmentStateGetSize(p->fprog), VGL_MEM_RAM);
+	if (!frag_data)
+		return GL_FALSE;
+	if (b->frag_data)
+		markAsDirty(b->frag_data);
+	b->frag_data = frag_data;
+	sceGxmShaderPatcherAddRefFragmentProgram(gxm_shader_patcher, p->fprog);
+	if (b->fprog)
+		sceGxmShaderPatcherReleaseFragmentProgram(gxm_shader_patcher, b->fprog);
+	b->fprog = p->fprog;
+	sceGxmPrecomputedFragmentStateInit(&b->frag_state, b->fprog, frag_data);
+	for (int i = 0; i < p->max_frag_texunit_idx; i++) {
+		texture *tex = get_frag_sampler_texture(p, i);
+		if (tex) {
+			b->textures[i] = tex->gxm_tex;
+			sceGxmPrecomputedFragmentStateSetTexture(&b->frag_state, i, &b->textures[i]);
+		}
+	}
+	if (b->frag_unifs)
+		sceGxmPrecomputedFragmentStateSetDefaultUniformBuffer(&b->frag_state, b->frag_unifs);
+	return GL_TRUE;
+}
+
+// Releases a shader reference held by baked objects, deleting the shader if it was marked for deletion
+static void release_baked_shader(shader *s) {
+	s->ref_counter--;
+	if (s->dirty && s->ref_counter == 0)
+		release_shader(s);
+}
+
+static void release_baked_objects(baked_objects *b) {
+	// Unlinking the objects from the alive ones
+	if (baked_list == b)
+		baked_list = (baked_objects *)b->next;
+	else {
+		baked_objects *prev = baked_list;
+		while (prev->next != b) {
+			prev = (baked_objects *)prev->next;
+		}
+		prev->next = b->next;
+	}
+
+	// Releasing patched programs before the shaders they got patched from
+	if (b->vprog)
+		sceGxmShaderPatcherReleaseVertexProgram(gxm_shader_patcher, b->vprog);
+	if (b->fprog)
+		sceGxmShaderPatcherReleaseFragmentProgram(gxm_shader_patcher, b->fprog);
+	release_baked_shader(b->vshader);
+	release_baked_shader(b->fshader);
+	if (b->draw_data)
+		markAsDirty(b->draw_data);
+	if (b->vert_data)
+		markAsDirty(b->vert_data);
+	if (b->frag_data)
+		markAsDirty(b->frag_data);
+	if (b->vert_unifs)
+		markAsDirty(b->vert_unifs);
+	if (b->frag_unifs)
+		markAsDirty(b->frag_unifs);
+	vglFree(b);
+}
+
+GLuint vglBakeObjects(GLenum mode, GLsizei count, GLboolean implicit_wvp) {
+	SceGxmPrimitiveType gxm_p;
+	switch (mode) {
+	case GL_POINTS:
+		gxm_p = SCE_GXM_PRIMITIVE_POINTS;
+		break;
+	case GL_LINES:
+		gxm_p = SCE_GXM_PRIMITIVE_LINES;
+		break;
+	case GL_TRIANGLES:
+		gxm_p = SCE_GXM_PRIMITIVE_TRIANGLES;
+		break;
+	case GL_TRIANGLE_STRIP:
+		gxm_p = SCE_GXM_PRIMITIVE_TRIANGLE_STRIP;
+		break;
+	case GL_TRIANGLE_FAN:
+		gxm_p = SCE_GXM_PRIMITIVE_TRIANGLE_FAN;
+		break;
+	default:
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_ENUM, 0, mode)
+	}
+#ifndef SKIP_ERROR_HANDLING
+	if (count <= 0) {
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_VALUE, 0, count)
+	} else if (!cur_program || !index_object) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, 0)
+	}
+#endif
+	program *p = &progs[cur_program - 1];
+
+	// Check if a blend info rebuild is required
+	if ((p->blend_info.raw != blend_info.raw) || (is_fbo_float != p->is_fbo_float)) {
+		p->is_fbo_float = is_fbo_float;
+		p->blend_info.raw = blend_info.raw;
+		rebuild_frag_shader(p->fshader->id, &p->fprog, (SceGxmProgram *)p->vshader->prog, is_fbo_float ? SCE_GXM_OUTPUT_REGISTER_FORMAT_HALF4 : SCE_GXM_OUTPUT_REGISTER_FORMAT_UCHAR4);
+	}
+
+	baked_objects *b = (baked_objects *)vglCalloc(1, sizeof(baked_objects));
+	if (!b) {
+		SET_GL_ERROR_WITH_RET(GL_OUT_OF_MEMORY, 0)
+	}
+	b->next = baked_list;
+	baked_list = b;
+
+	// Holding references to the shaders and the patched vertex program, so that they outlive a program deletion
+	b->prog = cur_program;
+	b->vshader = p->vshader;
+	b->fshader = p->fshader;
+	b->vshader->ref_counter++;
+	b->fshader->ref_counter++;
+	b->vprog = p->vprog;
+	sceGxmShaderPatcherAddRefVertexProgram(gxm_shader_patcher, b->vprog);
+	b->mode = mode;
+	b->count = count;
+
+	// Baking current uniforms values
+	b->vert_unifs = bake_uniforms(p->vshader->prog, p->vert_uniforms, p->wvp, implicit_wvp);
+	b->frag_unifs = bake_uniforms(p->fshader->prog, p->frag_uniforms, NULL, GL_FALSE);
+
+	// Baking vertex streams and indices
+	b->draw_data = gpu_alloc_mapped_aligned(SCE_GXM_PRECOMPUTED_ALIGNMENT, sceGxmPrecomputedDrawGetSize(b->vprog), VGL_MEM_RAM);
+	b->vert_data = gpu_alloc_mapped_aligned(SCE_GXM_PRECOMPUTED_ALIGNMENT, sceGxmPrecomputedVertexStateGetSize(b->vprog), VGL_MEM_RAM);
+	if (!b->draw_data || !b->vert_data || !bake_fragment_state(b, p)) {
+		release_baked_objects(b);
+		SET_GL_ERROR_WITH_RET(GL_OUT_OF_MEMORY, 0)
+	}
+	sceGxmPrecomputedDrawInit(&b->draw, b->vprog, b->draw_data);
+	sceGxmPrecomputedDrawSetAllVertexStreams(&b->draw, objects_streams);
+	sceGxmPrecomputedDrawSetParams(&b->draw, gxm_p, SCE_GXM_INDEX_FORMAT_U16, index_object, count);
+	sceGxmPrecomputedVertexStateInit(&b->vert_state, b->vprog, b->vert_data);
+	if (b->vert_unifs)
+		sceGxmPrecomputedVertexStateSetDefaultUniformBuffer(&b->vert_state, b->vert_unifs);
+
+	return (GLuint)b;
+}
+
+// Makes the fragment state of baked objects match current blending settings and bound textures
+static GLboolean prepare_baked_objects(baked_objects *b, program *p) {
+	// Check if a blend info rebuild is required
+	if ((p->blend_info.raw != blend_info.raw) || (is_fbo_float != p->is_fbo_float)) {
+		p->is_fbo_float = is_fbo_float;
+		p->blend_info.raw = blend_info.raw;
+		rebuild_frag_shader(p->fshader->id, &p->fprog, (SceGxmProgram *)p->vshader->prog, is_fbo_float ? SCE_GXM_OUTPUT_REGISTER_FORMAT_HALF4 : SCE_GXM_OUTPUT_REGISTER_FORMAT_UCHAR4);
+	}
+
+	// Rebaking fragment state if fragment program or bound textures changed since last draw
+	GLboolean needs_rebake = p->fprog != b->fprog;
+	for (int i = 0; i < p->max_frag_texunit_idx; i++) {
+		texture *tex = get_frag_sampler_texture(p, i);
+		if (tex) {
+			// Baked textures get bound without going through setFragmentTexture, so pending uploads are waited here
+			waitTextureUpload(tex);
+			if (!needs_rebake)
+				needs_rebake = sceClibMemcmp(&b->textures[i], &tex->gxm_tex, sizeof(SceGxmTexture)) != 0;
+		}
+	}
+	if (needs_rebake) {
+		// Queued draws may still refer to the current fragment state
+		if (b->queued)
+			vglFlushBakedObjectsQueue();
+		return bake_fragment_state(b, p);
+	}
+	return GL_TRUE;
+}
+
+// Issues the draw of baked objects skipping programs and precomputed states already set by the previous one
+static void issue_baked_objects(baked_objects *b) {
+	if (issued_vprog != b->vprog) {
+		sceGxmSetVertexProgram(gxm_context, b->vprog);
+		issued_vprog = b->vprog;
+	}
+	if (issued_fprog != b->fprog) {
+		sceGxmSetFragmentProgram(gxm_context, b->fprog);
+		issued_fprog = b->fprog;
+	}
+	if (issued_vert_state != &b->vert_state) {
+		sceGxmSetPrecomputedVertexState(gxm_context, &b->vert_state);
+		issued_vert_state = &b->vert_state;
+	}
+	if (issued_frag_state != &b->frag_state) {
+		sceGxmSetPrecomputedFragmentState(gxm_context, &b->frag_state);
+		issued_frag_state = &b->frag_state;
+	}
+	sceGxmDrawPrecomputed(gxm_context, &b->draw);
+}
+
+// Goes back to non precomputed state for regular draws
+static void end_baked_objects_draws(void) {
+	sceGxmSetPrecomputedVertexState(gxm_context, NULL);
+	sceGxmSetPrecomputedFragmentState(gxm_context, NULL);
+	vglRestoreVertexUniformBuffer();
+	vglRestoreFragmentUniformBuffer();
+
+	// Regular draws set their own programs, so nothing issued so far can be assumed as still set
+	issued_vprog = NULL;
+	issued_fprog = NULL;
+	issued_vert_state = NULL;
+	issued_frag_state = NULL;
+
+	// Precomputed draws bypass the binds tracked on sceGxm context
+	invalidateContextBinds();
+}
+
+/*
+ * Sort key for queued draws: program, fragment program (blending settings), first texture and depth state,
+ * from the most to the least expensive state change.
+ */
+static uint64_t get_queued_draw_key(baked_objects *b) {
+	uint64_t key = (uint64_t)b->prog << 48;
+	key |= (uint64_t)(((uint32_t)b->fprog >> 4) & 0xFFFF) << 32;
+	key |= (uint64_t)(((uint32_t)sceGxmTextureGetData(&b->textures[0]) >> 4) & 0xFFFFFF) << 8;
+	key |= (depth_test_state ? (depth_func << 2) : 0) | (depth_test_state << 1) | depth_mask_state;
+	return key;
+}
+
+static int compare_queued_draws(const void *a, const void *b) {
+	const queued_draw *d1 = (const queued_draw *)a;
+	const queued_draw *d2 = (const queued_draw *)b;
+	if (d1->key != d2->key)
+		return d1->key < d2->key ? -1 : 1;
+	return d1->seq < d2->seq ? -1 : 1;
+}
+
+static void set_queued_draw_depth_state(queued_draw *d) {
+	SceGxmDepthFunc func = d->depth_test ? d->depth_func : SCE_GXM_DEPTH_FUNC_ALWAYS;
+	sceGxmSetFrontDepthFunc(gxm_context, func);
+	sceGxmSetBackDepthFunc(gxm_context, func);
+	change_depth_write(d->depth_mask ? SCE_GXM_DEPTH_WRITE_ENABLED : SCE_GXM_DEPTH_WRITE_DISABLED);
+}
+
+void vglFlushBakedObjectsQueue(void) {
+	if (!draw_queue_num)
+		return;
+
+	// Sorting runs of opaque draws, blended draws act as barriers and keep their submission order
+	uint32_t run_start = 0;
+	for (uint32_t i = 0; i <= draw_queue_num; i++) {
+		if (i == draw_queue_num || draw_queue[i].is_blended) {
+			if (i - run_start > 1)
+				qsort(&draw_queue[run_start], i - run_start, sizeof(queued_draw), compare_queued_draws);
+			run_start = i + 1;
+		}
+	}
+
+	uint8_t last_depth_state = 0xFF;
+	for (uint32_t i = 0; i < draw_queue_num; i++) {
+		queued_draw *d = &draw_queue[i];
+		uint8_t depth_state = (d->depth_func << 2) | (d->depth_test << 1) | d->depth_mask;
+		if (depth_state != last_depth_state) {
+			set_queued_draw_depth_state(d);
+			last_depth_state = depth_state;
+		}
+		if (d->gxm_p == SCE_GXM_PRIMITIVE_LINES || d->gxm_p == SCE_GXM_PRIMITIVE_POINTS) {
+			SceGxmPolygonMode mode = d->gxm_p == SCE_GXM_PRIMITIVE_LINES ? SCE_GXM_POLYGON_MODE_LINE : SCE_GXM_POLYGON_MODE_POINT_01UV;
+			sceGxmSetFrontPolygonMode(gxm_context, mode);
+			sceGxmSetBackPolygonMode(gxm_context, mode);
+		}
+		issue_baked_objects(d->objects);
+		restore_polygon_mode(d->gxm_p);
+		d->objects->queued = GL_FALSE;
+	}
+	end_baked_objects_draws();
+	change_depth_func();
+	draw_queue_num = 0;
+}
+
+void vglEnableBakedObjectsQueue(GLboolean enable) {
+	if (!enable)
+		vglFlushBakedObjectsQueue();
+	draw_queue_enabled = enable;
+}
+
+void vglDrawBakedObjects(GLuint objects) {
+	baked_objects *b = (baked_objects *)objects;
+#ifndef SKIP_ERROR_HANDLING
+	if (!b) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	} else if (phase == MODEL_CREATION) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+#endif
+	program *p = &progs[b->prog - 1];
+#ifndef SKIP_ERROR_HANDLING
+	// Deleted programs or programs relinked with other shaders invalidate baked objects
+	if (p->status != PROG_LINKED || p->vshader != b->vshader || p->fshader != b->fshader) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+#endif
+
+	// Preparing fragment state before touching polygon mode since a rebake may flush queued draws
+	if (!prepare_baked_objects(b, p)) {
+		SET_GL_ERROR(GL_OUT_OF_MEMORY)
+	}
+
+	SceGxmPrimitiveType gxm_p;
+	GLsizei count = b->count;
+	gl_primitive_to_gxm(b->mode, gxm_p, count);
+	sceneReset();
+
+	// Recording the draw with the state it depends on if draws queueing is enabled
+	if (draw_queue_enabled) {
+		if (draw_queue_num == draw_queue_size) {
+			uint32_t new_size = draw_queue_size ? draw_queue_size * 2 : DRAW_QUEUE_MIN_SIZE;
+			queued_draw *new_queue = (queued_draw *)vglRealloc(draw_queue, new_size * sizeof(queued_draw));
+			if (!new_queue) {
+				restore_polygon_mode(gxm_p);
+				SET_GL_ERROR(GL_OUT_OF_MEMORY)
+			}
+			draw_queue = new_queue;
+			draw_queue_size = new_size;
+		}
+		queued_draw *d = &draw_queue[draw_queue_num];
+		d->objects = b;
+		d->key = get_queued_draw_key(b);
+		d->seq = draw_queue_num++;
+		d->gxm_p = gxm_p;
+		d->is_blended = blend_state;
+		d->depth_test = depth_test_state;
+		d->depth_func = depth_func;
+		d->depth_mask = depth_mask_state;
+		b->queued = GL_TRUE;
+	} else {
+		issue_baked_objects(b);
+		end_baked_objects_draws();
+	}
+
+	restore_polygon_mode(gxm_p);
+}
+
+void vglDeleteBakedObjects(GLuint objects) {
+	if (objects) {
+		baked_objects *b = (baked_objects *)objects;
+		if (b->queued)
+			vglFlushBakedObjectsQueue();
+		release_baked_objects(b);
+	}
 }
 
 void vglGetShaderBinary(GLuint handle, GLsizei bufSize, GLsizei *length, void *binary) {
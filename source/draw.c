@@ -22,94 +22,529 @@
  */
 #include "shared.h"
 #include "vitaGL.h"
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
 
 GLboolean prim_is_non_native = GL_FALSE; // Flag for when a primitive not supported natively by sceGxm is used
 
+#define IDX_CACHE_MAX_ENTRIES 8 // Maximum number of converted index lists cached per element buffer
+
+// Converted index list cache entry for non native primitives drawn from element buffers
+typedef struct idx_cache_entry {
+	void *ptr; // Converted index list
+	const void *src; // Source index list in the element buffer
+	GLsizei count; // Number of indices in the source element buffer
+	GLsizei conv_count; // Number of indices in the converted index list
+	GLenum mode; // Primitive type of the draw call
+	GLboolean is_short; // Index format of the draw call
+	struct idx_cache_entry *next;
+} idx_cache_entry;
+
+static void quads_to_triangles_u16(uint16_t *dst, const uint16_t *src, int quads, uint16_t base) {
+#ifdef __ARM_NEON__
+	// Two quads per iteration: [a0 b0 c0 d0 a1 b1 c1 d1] -> [a0 b0 d0 b0 c0 d0 a1 b1 d1 b1 c1 d1]
+	static const uint8_t lut[24] = {
+		0, 1, 2, 3, 6, 7, 2, 3,
+		4, 5, 6, 7, 8, 9, 10, 11,
+		14, 15, 10, 11, 12, 13, 14, 15
+	};
+	uint8x8_t lut0 = vld1_u8(&lut[0]);
+	uint8x8_t lut1 = vld1_u8(&lut[8]);
+	uint8x8_t lut2 = vld1_u8(&lut[16]);
+	uint16x8_t b = vdupq_n_u16(base);
+	while (quads >= 2) {
+		uint16x8_t q = vaddq_u16(vld1q_u16(src), b);
+		uint8x8x2_t tbl = {{vreinterpret_u8_u16(vget_low_u16(q)), vreinterpret_u8_u16(vget_high_u16(q))}};
+		vst1_u16(dst, vreinterpret_u16_u8(vtbl2_u8(tbl, lut0)));
+		vst1_u16(dst + 4, vreinterpret_u16_u8(vtbl2_u8(tbl, lut1)));
+		vst1_u16(dst + 8, vreinterpret_u16_u8(vtbl2_u8(tbl, lut2)));
+		src += 8;
+		dst += 12;
+		quads -= 2;
+	}
+#endif
+	for (int i = 0; i < quads; i++) {
+		dst[i * 6] = src[i * 4] + base;
+		dst[i * 6 + 1] = src[i * 4 + 1] + base;
+		dst[i * 6 + 2] = src[i * 4 + 3] + base;
+		dst[i * 6 + 3] = src[i * 4 + 1] + base;
+		dst[i * 6 + 4] = src[i * 4 + 2] + base;
+		dst[i * 6 + 5] = src[i * 4 + 3] + base;
+	}
+}
+
+static void quads_to_triangles_u32(uint32_t *dst, const uint32_t *src, int quads, uint32_t base) {
+#ifdef __ARM_NEON__
+	// One quad per iteration: [a b c d] -> [a b] [d b] [c d]
+	static const uint8_t lut[8] = {12, 13, 14, 15, 4, 5, 6, 7};
+	uint8x8_t lut0 = vld1_u8(lut);
+	uint32x4_t b = vdupq_n_u32(base);
+	while (quads >= 1) {
+		uint32x4_t q = vaddq_u32(vld1q_u32(src), b);
+		uint8x8x2_t tbl = {{vreinterpret_u8_u32(vget_low_u32(q)), vreinterpret_u8_u32(vget_high_u32(q))}};
+		vst1_u32(dst, vget_low_u32(q));
+		vst1_u32(dst + 2, vreinterpret_u32_u8(vtbl2_u8(tbl, lut0)));
+		vst1_u32(dst + 4, vget_high_u32(q));
+		src += 4;
+		dst += 6;
+		quads--;
+	}
+#endif
+	for (int i = 0; i < quads; i++) {
+		dst[i * 6] = src[i * 4] + base;
+		dst[i * 6 + 1] = src[i * 4 + 1] + base;
+		dst[i * 6 + 2] = src[i * 4 + 3] + base;
+		dst[i * 6 + 3] = src[i * 4 + 1] + base;
+		dst[i * 6 + 4] = src[i * 4 + 2] + base;
+		dst[i * 6 + 5] = src[i * 4 + 3] + base;
+	}
+}
+
+static void line_strip_to_lines_u16(uint16_t *dst, const uint16_t *src, int lines, uint16_t base) {
+#ifdef __ARM_NEON__
+	// Eight lines per iteration by interleaving the strip with itself shifted by one
+	uint16x8_t b = vdupq_n_u16(base);
+	while (lines >= 8) {
+		uint16x8x2_t out = {{vaddq_u16(vld1q_u16(src), b), vaddq_u16(vld1q_u16(src + 1), b)}};
+		vst2q_u16(dst, out);
+		src += 8;
+		dst += 16;
+		lines -= 8;
+	}
+#endif
+	for (int i = 0; i < lines; i++) {
+		dst[i * 2] = src[i] + base;
+		dst[i * 2 + 1] = src[i + 1] + base;
+	}
+}
+
+static void line_strip_to_lines_u32(uint32_t *dst, const uint32_t *src, int lines, uint32_t base) {
+#ifdef __ARM_NEON__
+	uint32x4_t b = vdupq_n_u32(base);
+	while (lines >= 4) {
+		uint32x4x2_t out = {{vaddq_u32(vld1q_u32(src), b), vaddq_u32(vld1q_u32(src + 1), b)}};
+		vst2q_u32(dst, out);
+		src += 4;
+		dst += 8;
+		lines -= 4;
+	}
+#endif
+	for (int i = 0; i < lines; i++) {
+		dst[i * 2] = src[i] + base;
+		dst[i * 2 + 1] = src[i + 1] + base;
+	}
+}
+
+// Narrows a 32 bit index list to 16 bit applying a base vertex, returns the highest source index value
+static uint32_t narrow_indices(uint16_t *dst, const uint32_t *src, GLsizei count, int32_t base) {
+	uint32_t top = 0;
+#ifdef __ARM_NEON__
+	uint32x4_t vtop = vdupq_n_u32(0);
+	uint32x4_t b = vdupq_n_u32(base);
+	while (count >= 8) {
+		uint32x4_t lo = vld1q_u32(src);
+		uint32x4_t hi = vld1q_u32(src + 4);
+		vtop = vmaxq_u32(vtop, vmaxq_u32(lo, hi));
+		vst1q_u16(dst, vcombine_u16(vmovn_u32(vaddq_u32(lo, b)), vmovn_u32(vaddq_u32(hi, b))));
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+	uint32x2_t vtop2 = vmax_u32(vget_low_u32(vtop), vget_high_u32(vtop));
+	vtop2 = vpmax_u32(vtop2, vtop2);
+	top = vget_lane_u32(vtop2, 0);
+#endif
+	for (int i = 0; i < count; i++) {
+		if (src[i] > top)
+			top = src[i];
+		dst[i] = src[i] + base;
+	}
+	return top;
+}
+
+static inline GLsizei get_converted_indices_num(GLenum mode, GLsizei count) {
+	switch (mode) {
+	case GL_QUADS:
+		return (count / 4) * 6;
+	case GL_LINE_STRIP:
+		return count > 1 ? (count - 1) * 2 : 0;
+	case GL_LINE_LOOP:
+		return count > 1 ? count * 2 : 0;
+	default:
+		return count;
+	}
+}
+
+// Converts an index list to a natively supported primitive index list, returns the new indices count
+static GLsizei convert_indices(void *dst, const void *src, GLenum mode, GLsizei count, GLboolean is_short, int32_t base) {
+	GLsizei conv_count = get_converted_indices_num(mode, count);
+	if (!conv_count)
+		return 0;
+	if (is_short) {
+		uint16_t *d = (uint16_t *)dst;
+		const uint16_t *s = (const uint16_t *)src;
+		switch (mode) {
+		case GL_QUADS:
+			quads_to_triangles_u16(d, s, count / 4, base);
+			break;
+		case GL_LINE_STRIP:
+			line_strip_to_lines_u16(d, s, count - 1, base);
+			break;
+		case GL_LINE_LOOP:
+			line_strip_to_lines_u16(d, s, count - 1, base);
+			d[(count - 1) * 2] = s[count - 1] + base;
+			d[(count - 1) * 2 + 1] = s[0] + base;
+			break;
+		default:
+			if (base) {
+				for (int i = 0; i < count; i++) {
+					d[i] = s[i] + base;
+				}
+			} else
+				vgl_fast_memcpy(d, s, count * sizeof(uint16_t));
+			break;
+		}
+	} else {
+		uint32_t *d = (uint32_t *)dst;
+		const uint32_t *s = (const uint32_t *)src;
+		switch (mode) {
+		case GL_QUADS:
+			quads_to_triangles_u32(d, s, count / 4, base);
+			break;
+		case GL_LINE_STRIP:
+			line_strip_to_lines_u32(d, s, count - 1, base);
+			break;
+		case GL_LINE_LOOP:
+			line_strip_to_lines_u32(d, s, count - 1, base);
+			d[(count - 1) * 2] = s[count - 1] + base;
+			d[(count - 1) * 2 + 1] = s[0] + base;
+			break;
+		default:
+			if (base) {
+				for (int i = 0; i < count; i++) {
+					d[i] = s[i] + base;
+				}
+			} else
+				vgl_fast_memcpy(d, s, count * sizeof(uint32_t));
+			break;
+		}
+	}
+	return conv_count;
+}
+
+// Gets a converted index list for a non native primitive from an element buffer, converting and caching it if required
+static void *get_cached_indices(gpubuffer *gpu_buf, const void *src, GLenum mode, GLsizei *count, GLboolean is_short) {
+	idx_cache_entry *prev = NULL, *tail_prev = NULL;
+	idx_cache_entry *e = (idx_cache_entry *)gpu_buf->idx_cache;
+	int entries_num = 0;
+	while (e) {
+		if (e->src == src && e->count == *count && e->mode == mode && e->is_short == is_short) {
+			// Moving the hit entry on top of the list
+			if (prev) {
+				prev->next = e->next;
+				e->next = (idx_cache_entry *)gpu_buf->idx_cache;
+				gpu_buf->idx_cache = e;
+			}
+			*count = e->conv_count;
+			return e->ptr;
+		}
+		entries_num++;
+		tail_prev = prev;
+		prev = e;
+		e = e->next;
+	}
+
+	// Converting the index list and storing it in the cache
+	uint32_t idx_size = is_short ? sizeof(uint16_t) : sizeof(uint32_t);
+	GLsizei conv_count = get_converted_indices_num(mode, *count);
+	if (!conv_count) {
+		// Not enough indices to form a single primitive, nothing to draw
+		*count = 0;
+		return (void *)src;
+	}
+	void *ptr = gpu_alloc_mapped(conv_count * idx_size, gpu_buf->type);
+	if (!ptr) {
+		ptr = gpu_alloc_mapped_temp(conv_count * idx_size);
+		*count = convert_indices(ptr, src, mode, *count, is_short, 0);
+		return ptr;
+	}
+	if (entries_num == IDX_CACHE_MAX_ENTRIES) {
+		// Recycling the least recently used entry
+		e = prev;
+		markAsDirty(e->ptr);
+		tail_prev->next = NULL;
+	} else
+		e = (idx_cache_entry *)vglMalloc(sizeof(idx_cache_entry));
+	e->ptr = ptr;
+	e->src = src;
+	e->count = *count;
+	e->conv_count = conv_count;
+	e->mode = mode;
+	e->is_short = is_short;
+	e->next = (idx_cache_entry *)gpu_buf->idx_cache;
+	gpu_buf->idx_cache = e;
+	*count = convert_indices(ptr, src, mode, *count, is_short, 0);
+	return ptr;
+}
+
+// Releases the narrowed 16 bit copy of a 32 bit element buffer
+static void release_narrowed_copy(gpubuffer *gpu_buf) {
+	if (gpu_buf->short_used)
+		markAsDirty(gpu_buf->short_ptr);
+	else
+		vgl_free(gpu_buf->short_ptr);
+	gpu_buf->short_ptr = NULL;
+}
+
+// Frees the converted index lists cached for an element buffer
+static void purge_converted_indices(gpubuffer *gpu_buf) {
+	idx_cache_entry *e = (idx_cache_entry *)gpu_buf->idx_cache;
+	while (e) {
+		idx_cache_entry *next = e->next;
+		markAsDirty(e->ptr);
+		vglFree(e);
+		e = next;
+	}
+	gpu_buf->idx_cache = NULL;
+}
+
+void purgeIndicesCache(gpubuffer *gpu_buf) {
+	purge_converted_indices(gpu_buf);
+	if (gpu_buf->short_ptr)
+		release_narrowed_copy(gpu_buf);
+	gpu_buf->top_idx = 0;
+}
+
+void invalidateIndicesRange(gpubuffer *gpu_buf, int32_t offset, int32_t size) {
+	purge_converted_indices(gpu_buf);
+	if (gpu_buf->short_ptr) {
+		// The narrowed copy is kept and only the written range gets narrowed again on next usage
+		if (!gpu_buf->dirty_end) {
+			gpu_buf->dirty_start = offset;
+			gpu_buf->dirty_end = offset + size;
+		} else {
+			gpu_buf->dirty_start = min(gpu_buf->dirty_start, offset);
+			gpu_buf->dirty_end = max(gpu_buf->dirty_end, offset + size);
+		}
+	} else
+		gpu_buf->top_idx = 0;
+}
+
+// Gets a narrowed 16 bit copy of a 32 bit element buffer, creating it on first usage if all indices fit in 16 bits
+static uint16_t *get_narrowed_element_buffer(gpubuffer *gpu_buf) {
+	uint32_t num = gpu_buf->size / sizeof(uint32_t);
+	if (!gpu_buf->top_idx) {
+		uint16_t *ptr = gpu_alloc_mapped(num * sizeof(uint16_t), gpu_buf->type);
+		if (!ptr)
+			return NULL;
+		gpu_buf->top_idx = narrow_indices(ptr, (uint32_t *)gpu_buf->ptr, num, 0) + 1;
+		gpu_buf->dirty_end = 0;
+		if (gpu_buf->top_idx > 0x10000)
+			vgl_free(ptr);
+		else {
+			gpu_buf->short_ptr = ptr;
+			gpu_buf->short_used = GL_FALSE;
+		}
+	} else if (gpu_buf->dirty_end) {
+		uint32_t start = gpu_buf->dirty_start / sizeof(uint32_t);
+		uint32_t end = min((gpu_buf->dirty_end + sizeof(uint32_t) - 1) / sizeof(uint32_t), num);
+		uint16_t *ptr = (uint16_t *)gpu_buf->short_ptr;
+		gpu_buf->dirty_end = 0;
+		if (gpu_buf->short_used) {
+			// The GPU may still be reading the current copy, so the update goes into a new one
+			ptr = gpu_alloc_mapped(num * sizeof(uint16_t), gpu_buf->type);
+			if (!ptr) {
+				release_narrowed_copy(gpu_buf);
+				gpu_buf->top_idx = 0;
+				return NULL;
+			}
+			if (start)
+				vgl_fast_memcpy(ptr, gpu_buf->short_ptr, start * sizeof(uint16_t));
+			if (end < num)
+				vgl_fast_memcpy(ptr + end, (uint16_t *)gpu_buf->short_ptr + end, (num - end) * sizeof(uint16_t));
+			markAsDirty(gpu_buf->short_ptr);
+			gpu_buf->short_ptr = ptr;
+			gpu_buf->short_used = GL_FALSE;
+		}
+
+		// Overwritten indices may have been the highest ones, so the stored top is only ever raised
+		uint32_t top = narrow_indices(ptr + start, (uint32_t *)gpu_buf->ptr + start, end - start, 0) + 1;
+		if (top > gpu_buf->top_idx) {
+			gpu_buf->top_idx = top;
+			if (top > 0x10000)
+				release_narrowed_copy(gpu_buf);
+		}
+	}
+	return (uint16_t *)gpu_buf->short_ptr;
+}
+
+// Gets the source index list for a glDrawElements call, narrowing 32 bit indices to 16 bit when possible
+static uint16_t *get_elements_source(gpubuffer *gpu_buf, const GLvoid *gl_indices, GLsizei count, int32_t base, GLboolean *is_short, GLboolean *is_temp) {
+	*is_temp = GL_FALSE;
+	if (gpu_buf) {
+		if (!isBufferPersistent(gpu_buf)) {
+			if (!*is_short) {
+				uint16_t *short_ptr = get_narrowed_element_buffer(gpu_buf);
+				if (short_ptr && (base <= 0 || gpu_buf->top_idx + base <= 0x10000)) {
+					*is_short = GL_TRUE;
+					return short_ptr + (uint32_t)gl_indices / sizeof(uint32_t);
+				}
+			}
+			return (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices);
+		}
+
+		// Persistent buffers can be modified at any time, so their content is handled like client index lists
+		gl_indices = (uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices;
+	}
+	if (!*is_short) {
+		// Client index lists are narrowed straight into the temporary index list used for the draw
+		uint16_t *ptr = gpu_alloc_mapped_temp(count * sizeof(uint16_t));
+		uint32_t top = narrow_indices(ptr, (uint32_t *)gl_indices, count, base);
+		if ((int64_t)top + base <= 0xFFFF) {
+			*is_short = GL_TRUE;
+			*is_temp = GL_TRUE;
+			return ptr;
+		}
+	}
+	return (uint16_t *)gl_indices;
+}
+
 #define setup_elements_indices(type_t) \
 	type_t *ptr; \
-	if (gpu_buf != NULL && !prim_is_non_native) { \
-		ptr = (type_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices); \
-		gpu_buf->used = GL_TRUE; \
-	} else { \
-		switch (mode) { \
-		case GL_QUADS: \
-			ptr = gpu_alloc_mapped_temp(count * 3 * sizeof(type_t)); \
-			for (int i = 0; i < count / 4; i++) { \
-				ptr[i * 6] = src[i * 4]; \
-				ptr[i * 6 + 1] = src[i * 4 + 1]; \
-				ptr[i * 6 + 2] = src[i * 4 + 3]; \
-				ptr[i * 6 + 3] = src[i * 4 + 1]; \
-				ptr[i * 6 + 4] = src[i * 4 + 2]; \
-				ptr[i * 6 + 5] = src[i * 4 + 3]; \
-			} \
-			count = (count / 2) * 3; \
-			break; \
-		case GL_LINE_STRIP: \
-			ptr = gpu_alloc_mapped_temp((count - 1) * 2 * sizeof(type_t)); \
-			for (int i = 0; i < count - 1; i++) { \
-				ptr[i * 2] = src[i]; \
-				ptr[i * 2 + 1] = src[i + 1]; \
-			} \
-			count = (count - 1) * 2; \
-			break; \
-		case GL_LINE_LOOP: \
-			ptr = gpu_alloc_mapped_temp(count * 2 * sizeof(type_t)); \
-			for (int i = 0; i < count - 1; i++) { \
-				ptr[i * 2] = src[i]; \
-				ptr[i * 2 + 1] = src[i + 1]; \
+	if (gpu_buf != NULL && !is_temp && !(prim_is_non_native && isBufferPersistent(gpu_buf))) { \
+		if (prim_is_non_native) \
+			ptr = (type_t *)get_cached_indices(gpu_buf, src, mode, &count, sizeof(type_t) == 2); \
+		else { \
+			ptr = (type_t *)src; \
+			if (type == GL_UNSIGNED_INT && is_short) \
+				gpu_buf->short_used = GL_TRUE; \
+			else { \
+				markBufferAsUsed(gpu_buf) \
 			} \
-			ptr[(count - 1) * 2] = src[count - 1]; \
-			ptr[(count - 1) * 2 + 1] = src[0]; \
-			count = count * 2; \
-			break; \
-		default: \
-			ptr = gpu_alloc_mapped_temp(count * sizeof(type_t)); \
-			vgl_fast_memcpy(ptr, src, count * sizeof(type_t)); \
-			break; \
 		} \
+	} else if (is_temp && !prim_is_non_native) { \
+		ptr = (type_t *)src; \
+	} else { \
+		ptr = gpu_alloc_mapped_temp(get_converted_indices_num(mode, count) * sizeof(type_t)); \
+		count = convert_indices(ptr, src, mode, count, sizeof(type_t) == 2, 0); \
 	}
-	
+
 #define setup_elements_indices_with_base(type_t) \
 	type_t *ptr; \
-	switch (mode) { \
-	case GL_QUADS: \
-		ptr = gpu_alloc_mapped_temp(count * 3 * sizeof(type_t)); \
-		for (int i = 0; i < count / 4; i++) { \
-			ptr[i * 6] = src[i * 4] + baseVertex; \
-			ptr[i * 6 + 1] = src[i * 4 + 1] + baseVertex; \
-			ptr[i * 6 + 2] = src[i * 4 + 3] + baseVertex; \
-			ptr[i * 6 + 3] = src[i * 4 + 1] + baseVertex; \
-			ptr[i * 6 + 4] = src[i * 4 + 2] + baseVertex; \
-			ptr[i * 6 + 5] = src[i * 4 + 3] + baseVertex; \
-		} \
-		count = (count / 2) * 3; \
-		break; \
-	case GL_LINE_STRIP: \
-		ptr = gpu_alloc_mapped_temp((count - 1) * 2 * sizeof(type_t)); \
-		for (int i = 0; i < count - 1; i++) { \
-			ptr[i * 2] = src[i] + baseVertex; \
-			ptr[i * 2 + 1] = src[i + 1] + baseVertex; \
-		} \
-		count = (count - 1) * 2; \
-		break; \
-	case GL_LINE_LOOP: \
-		ptr = gpu_alloc_mapped_temp(count * 2 * sizeof(type_t)); \
-		for (int i = 0; i < count - 1; i++) { \
-			ptr[i * 2] = src[i] + baseVertex; \
-			ptr[i * 2 + 1] = src[i + 1] + baseVertex; \
-		} \
-		ptr[(count - 1) * 2] = src[count - 1] + baseVertex; \
-		ptr[(count - 1) * 2 + 1] = src[0] + baseVertex; \
-		count = count * 2; \
-		break; \
-	default: \
-		ptr = gpu_alloc_mapped_temp(count * sizeof(type_t)); \
-		for (int i = 0; i < count; i++) { \
-			ptr[i] = src[i] + baseVertex; \
-		} \
-		break; \
+	if (is_temp && !prim_is_non_native) { \
+		ptr = (type_t *)src; \
+	} else { \
+		ptr = gpu_alloc_mapped_temp(get_converted_indices_num(mode, count) * sizeof(type_t)); \
+		count = convert_indices(ptr, src, mode, count, sizeof(type_t) == 2, is_temp ? 0 : baseVertex); \
+	}
+
+// Gets the progressive indices list for a glDrawArrays call, returns the indices count
+static uint16_t *get_default_indices(GLenum mode, GLint first, GLsizei *count) {
+	uint16_t *ptr;
+	uint32_t idx_num = reserveDefaultIndices(first + *count);
+	if ((uint32_t)(first + *count) > idx_num) {
+		// Growing the progressive indices buffers failed, clamping the draw to the addressable vertices
+		*count = (uint32_t)first < idx_num ? idx_num - first : 0;
+		if (*count < 2) {
+			*count = 0;
+			return default_idx_ptr;
+		}
+	}
+	switch (mode) {
+	case GL_QUADS:
+		ptr = default_quads_idx_ptr + (first / 2) * 3;
+		*count = (*count / 2) * 3;
+		break;
+	case GL_LINE_STRIP:
+		ptr = default_line_strips_idx_ptr + first * 2;
+		*count = get_converted_indices_num(mode, *count);
+		break;
+	case GL_LINE_LOOP:
+		if (*count < 2) {
+			ptr = default_idx_ptr + first;
+			*count = 0;
+			break;
+		}
+		ptr = gpu_alloc_mapped_temp(*count * 2 * sizeof(uint16_t));
+		vgl_fast_memcpy(ptr, default_line_strips_idx_ptr + first * 2, (*count - 1) * 2 * sizeof(uint16_t));
+		ptr[(*count - 1) * 2] = first + *count - 1;
+		ptr[(*count - 1) * 2 + 1] = first;
+		*count *= 2;
+		break;
+	default:
+		ptr = default_idx_ptr + first;
+		break;
+	}
+	return ptr;
+}
+
+// Moves the base of all vertex attributes arrays by the given number of vertices
+static void shift_vertex_attribs(GLint num) {
+	if (cur_program != 0) {
+		for (int i = 0; i < VERTEX_ATTRIBS_NUM; i++) {
+			cur_vao->vertex_attrib_offsets[i] += num * cur_vao->vertex_stream_config[i].stride;
+		}
+	} else
+		shift_ffp_vertex_attribs(num);
+}
+
+// Splits a glDrawArrays call exceeding 16 bit addressing in several draws with rebased vertex attributes arrays
+static void draw_arrays_chunked(GLenum mode, SceGxmPrimitiveType gxm_p, GLint first, GLsizei count, GLsizei primcount) {
+	GLsizei overlap;
+	switch (mode) {
+	case GL_TRIANGLE_STRIP:
+		overlap = 2; // Even chunk steps preserve strip winding order
+		break;
+	case GL_LINE_STRIP:
+		overlap = 1;
+		break;
+	case GL_TRIANGLE_FAN:
+	case GL_LINE_LOOP:
+		// Both primitives reference the first vertex from every chunk, so only the first chunk can be drawn
+#ifndef SKIP_ERROR_HANDLING
+		vgl_log("%s:%d Attempting to draw a triangle fan or line loop with glDrawArrays exceeding %d vertices, draw will be truncated.\n", __FILE__, __LINE__, MAX_DRAW_CHUNK_VERTICES);
+#endif
+		if (count > MAX_DRAW_CHUNK_VERTICES)
+			count = MAX_DRAW_CHUNK_VERTICES;
+		overlap = 0;
+		break;
+	default:
+		overlap = 0;
+		break;
 	}
 
+	GLint shift = first;
+	shift_vertex_attribs(first);
+	for (;;) {
+		GLsizei chunk_count = count > MAX_DRAW_CHUNK_VERTICES ? MAX_DRAW_CHUNK_VERTICES : count;
+		GLboolean is_draw_legal = GL_TRUE;
+		if (cur_program != 0)
+			is_draw_legal = _glDrawArrays_CustomShadersIMPL(chunk_count);
+		else
+			_glDrawArrays_FixedFunctionIMPL(chunk_count);
+
+#ifndef SKIP_ERROR_HANDLING
+		if (is_draw_legal)
+#endif
+		{
+			GLsizei idx_count = chunk_count;
+			uint16_t *ptr = get_default_indices(mode, 0, &idx_count);
+			if (primcount)
+				sceGxmDrawInstanced(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, idx_count * primcount, idx_count);
+			else
+				sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, idx_count);
+		}
+
+		if (chunk_count == count)
+			break;
+		shift_vertex_attribs(chunk_count - overlap);
+		shift += chunk_count - overlap;
+		count -= chunk_count - overlap;
+	}
+	shift_vertex_attribs(-shift);
+}
+
 void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
 #ifdef HAVE_DLISTS
 	// Enqueueing function to a display list if one is being compiled
@@ -126,47 +561,26 @@ void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
 	SceGxmPrimitiveType gxm_p;
 	gl_primitive_to_gxm(mode, gxm_p, count);
 	sceneReset();
-	GLboolean is_draw_legal = GL_TRUE;
+	if (cur_program == 0 && !(ffp_vertex_attrib_state & (1 << 0)))
+		return;
 
+	if (first + count > MAX_DRAW_CHUNK_VERTICES) {
+		draw_arrays_chunked(mode, gxm_p, first, count, 0);
+		restore_polygon_mode(gxm_p);
+		return;
+	}
+
+	GLboolean is_draw_legal = GL_TRUE;
 	if (cur_program != 0)
 		is_draw_legal = _glDrawArrays_CustomShadersIMPL(first + count);
-	else {
-		if (!(ffp_vertex_attrib_state & (1 << 0)))
-			return;
+	else
 		_glDrawArrays_FixedFunctionIMPL(first + count);
-	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		uint16_t *ptr;
-		switch (mode) {
-		case GL_QUADS:
-			ptr = default_quads_idx_ptr + (first / 2) * 3;
-			count = (count / 2) * 3;
-			break;
-		case GL_LINE_STRIP:
-			ptr = default_line_strips_idx_ptr + first * 2;
-			count = (count - 1) * 2;
-			break;
-		case GL_LINE_LOOP:
-			ptr = gpu_alloc_mapped_temp(count * 2 * sizeof(uint16_t));
-			vgl_fast_memcpy(ptr, default_line_strips_idx_ptr + first * 2, (count - 1) * 2 * sizeof(uint16_t));
-			ptr[(count - 1) * 2] = first + count - 1;
-			ptr[(count - 1) * 2 + 1] = first;
-			count *= 2;
-			break;
-		default:
-			ptr = default_idx_ptr + first;
-			break;
-		}
-
-#ifndef SKIP_ERROR_HANDLING
-		if (first + count > MAX_IDX_NUMBER) {
-			vgl_log("%s:%d Attempting to draw a model with glDrawArrays which is too big! Consider increasing MAX_IDX_NUMBER value...\n", __FILE__, __LINE__);
-		}	
-#endif
+		uint16_t *ptr = get_default_indices(mode, first, &count);
 		sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count);
 	}
 	restore_polygon_mode(gxm_p);
@@ -183,47 +597,26 @@ void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei prim
 	SceGxmPrimitiveType gxm_p;
 	gl_primitive_to_gxm(mode, gxm_p, count);
 	sceneReset();
-	GLboolean is_draw_legal = GL_TRUE;
+	if (cur_program == 0 && !(ffp_vertex_attrib_state & (1 << 0)))
+		return;
+
+	if (first + count > MAX_DRAW_CHUNK_VERTICES) {
+		draw_arrays_chunked(mode, gxm_p, first, count, primcount);
+		restore_polygon_mode(gxm_p);
+		return;
+	}
 
+	GLboolean is_draw_legal = GL_TRUE;
 	if (cur_program != 0)
 		is_draw_legal = _glDrawArrays_CustomShadersIMPL(first + count);
-	else {
-		if (!(ffp_vertex_attrib_state & (1 << 0)))
-			return;
+	else
 		_glDrawArrays_FixedFunctionIMPL(first + count);
-	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		uint16_t *ptr;
-		switch (mode) {
-		case GL_QUADS:
-			ptr = default_quads_idx_ptr + (first / 2) * 3;
-			count = (count / 2) * 3;
-			break;
-		case GL_LINE_STRIP:
-			ptr = default_line_strips_idx_ptr + first * 2;
-			count = (count - 1) * 2;
-			break;
-		case GL_LINE_LOOP:
-			ptr = gpu_alloc_mapped_temp(count * 2 * sizeof(uint16_t));
-			vgl_fast_memcpy(ptr, default_line_strips_idx_ptr + first * 2, (count - 1) * 2 * sizeof(uint16_t));
-			ptr[(count - 1) * 2] = first + count - 1;
-			ptr[(count - 1) * 2 + 1] = first;
-			count *= 2;
-			break;
-		default:
-			ptr = default_idx_ptr + first;
-			break;
-		}
-
-#ifndef SKIP_ERROR_HANDLING
-		if (first + count > MAX_IDX_NUMBER) {
-			vgl_log("%s:%d Attempting to draw a model with glDrawArrays which is too big! Consider increasing MAX_IDX_NUMBER value...\n", __FILE__, __LINE__);
-		}	
-#endif
+		uint16_t *ptr = get_default_indices(mode, first, &count);
 		sceGxmDrawInstanced(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count * primcount, count);
 	}
 	restore_polygon_mode(gxm_p);
@@ -251,20 +644,21 @@ void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *gl_in
 	GLboolean is_draw_legal = GL_TRUE;
 
 	gpubuffer *gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
-	uint16_t *src = gpu_buf ? (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices) : (uint16_t *)gl_indices;
+	GLboolean is_short = type == GL_UNSIGNED_SHORT, is_temp;
+	uint16_t *src = get_elements_source(gpu_buf, gl_indices, count, 0, &is_short, &is_temp);
 	if (cur_program != 0)
-		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, is_short);
 	else {
 		if (!(ffp_vertex_attrib_state & (1 << 0)))
 			return;
-		_glDrawElements_FixedFunctionIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		_glDrawElements_FixedFunctionIMPL(src, count, 0, is_short);
 	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		if (type == GL_UNSIGNED_SHORT) {
+		if (is_short) {
 			setup_elements_indices(uint16_t)
 			sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count);
 		} else {
@@ -292,20 +686,21 @@ void glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const GLv
 	GLboolean is_draw_legal = GL_TRUE;
 
 	gpubuffer *gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
-	uint16_t *src = gpu_buf ? (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices) : (uint16_t *)gl_indices;
+	GLboolean is_short = type == GL_UNSIGNED_SHORT, is_temp;
+	uint16_t *src = get_elements_source(gpu_buf, gl_indices, count, baseVertex, &is_short, &is_temp);
 	if (cur_program != 0)
-		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, is_short);
 	else {
 		if (!(ffp_vertex_attrib_state & (1 << 0)))
 			return;
-		_glDrawElements_FixedFunctionIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		_glDrawElements_FixedFunctionIMPL(src, count, 0, is_short);
 	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		if (type == GL_UNSIGNED_SHORT) {
+		if (is_short) {
 			setup_elements_indices_with_base(uint16_t)
 			sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count);
 		} else {
@@ -335,20 +730,21 @@ void glDrawRangeElements(GLenum mode, GLuint start, GLuint end, GLsizei count, G
 	GLboolean is_draw_legal = GL_TRUE;
 
 	gpubuffer *gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
-	uint16_t *src = gpu_buf ? (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices) : (uint16_t *)gl_indices;
+	GLboolean is_short = type == GL_UNSIGNED_SHORT, is_temp;
+	uint16_t *src = get_elements_source(gpu_buf, gl_indices, count, 0, &is_short, &is_temp);
 	if (cur_program != 0)
-		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, end + 1, type == GL_UNSIGNED_SHORT);
+		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, end + 1, is_short);
 	else {
 		if (!(ffp_vertex_attrib_state & (1 << 0)))
 			return;
-		_glDrawElements_FixedFunctionIMPL(src, count, end + 1, type == GL_UNSIGNED_SHORT);
+		_glDrawElements_FixedFunctionIMPL(src, count, end + 1, is_short);
 	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		if (type == GL_UNSIGNED_SHORT) {
+		if (is_short) {
 			setup_elements_indices(uint16_t)
 			sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count);
 		} else {
@@ -376,20 +772,21 @@ void glDrawRangeElementsBaseVertex(GLenum mode, GLuint start, GLuint end, GLsize
 	GLboolean is_draw_legal = GL_TRUE;
 
 	gpubuffer *gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
-	uint16_t *src = gpu_buf ? (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices) : (uint16_t *)gl_indices;
+	GLboolean is_short = type == GL_UNSIGNED_SHORT, is_temp;
+	uint16_t *src = get_elements_source(gpu_buf, gl_indices, count, baseVertex, &is_short, &is_temp);
 	if (cur_program != 0)
-		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, end + 1, type == GL_UNSIGNED_SHORT);
+		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, end + 1, is_short);
 	else {
 		if (!(ffp_vertex_attrib_state & (1 << 0)))
 			return;
-		_glDrawElements_FixedFunctionIMPL(src, count, end + 1, type == GL_UNSIGNED_SHORT);
+		_glDrawElements_FixedFunctionIMPL(src, count, end + 1, is_short);
 	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		if (type == GL_UNSIGNED_SHORT) {
+		if (is_short) {
 			setup_elements_indices_with_base(uint16_t)
 			sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count);
 		} else {
@@ -417,20 +814,21 @@ void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void
 	GLboolean is_draw_legal = GL_TRUE;
 
 	gpubuffer *gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
-	uint16_t *src = gpu_buf ? (uint16_t *)((uint8_t *)gpu_buf->ptr + (uint32_t)gl_indices) : (uint16_t *)gl_indices;
+	GLboolean is_short = type == GL_UNSIGNED_SHORT, is_temp;
+	uint16_t *src = get_elements_source(gpu_buf, gl_indices, count, 0, &is_short, &is_temp);
 	if (cur_program != 0)
-		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		is_draw_legal = _glDrawElements_CustomShadersIMPL(src, count, 0, is_short);
 	else {
 		if (!(ffp_vertex_attrib_state & (1 << 0)))
 			return;
-		_glDrawElements_FixedFunctionIMPL(src, count, 0, type == GL_UNSIGNED_SHORT);
+		_glDrawElements_FixedFunctionIMPL(src, count, 0, is_short);
 	}
 
 #ifndef SKIP_ERROR_HANDLING
 	if (is_draw_legal)
 #endif
 	{
-		if (type == GL_UNSIGNED_SHORT) {
+		if (is_short) {
 			setup_elements_indices(uint16_t)
 			sceGxmDrawInstanced(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, ptr, count * primcount, count);
 		} else {
@@ -461,15 +859,17 @@ void vglDrawObjects(GLenum mode, GLsizei count, GLboolean implicit_wvp) {
 	} else if (ffp_vertex_attrib_state & (1 << 0)) {
 		reload_ffp_shaders(NULL, NULL);
 		if (ffp_vertex_attrib_state & (1 << 1)) {
-			if (texture_slots[tex_unit->tex_id].status != TEX_VALID)
+			if (getTexture(tex_unit->tex_id)->status != TEX_VALID)
 				return;
-			sceGxmSetFragmentTexture(gxm_context, 0, &texture_slots[tex_unit->tex_id].gxm_tex);
-			sceGxmSetVertexStream(gxm_context, 1, texture_object);
-			if (ffp_vertex_num_params > 2)
-				sceGxmSetVertexStream(gxm_context, 2, color_object);
-		} else if (ffp_vertex_num_params > 1)
-			sceGxmSetVertexStream(gxm_context, 1, color_object);
-		sceGxmSetVertexStream(gxm_context, 0, vertex_object);
+			setFragmentTexture(0, getTexture(tex_unit->tex_id));
+			setVertexStream(1, texture_object);
+			if (ffp_vertex_num_params > 2) {
+				setVertexStream(2, color_object);
+			}
+		} else if (ffp_vertex_num_params > 1) {
+			setVertexStream(1, color_object);
+		}
+		setVertexStream(0, vertex_object);
 		sceGxmDraw(gxm_context, gxm_p, SCE_GXM_INDEX_FORMAT_U16, index_object, count);
 	}
 
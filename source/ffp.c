@@ -42,7 +42,7 @@
 
 #define SHADER_CACHE_SIZE 256
 
-#define VERTEX_UNIFORMS_NUM 13
+#define VERTEX_UNIFORMS_NUM 17
 #ifdef HAVE_HIGH_FFP_TEXUNITS
 #define FRAGMENT_UNIFORMS_NUM 19
 #else
@@ -161,10 +161,10 @@ typedef union shader_mask {
 #else
 		uint32_t fixed_mask : 3;
 		uint32_t pos_fixed_mask : 2;
-		uint32_t UNUSED : 3;
 #endif
+		uint32_t const_attribs_mask : 4;
 	};
-	uint32_t raw;
+	uint64_t raw;
 } shader_mask;
 #ifndef DISABLE_TEXTURE_COMBINER
 typedef union combiner_mask {
@@ -215,7 +215,11 @@ typedef enum {
 	LIGHT_GLOBAL_AMBIENT_V_UNIF,
 	NORMAL_MATRIX_UNIF,
 	POINT_SIZE_UNIF,
-	AMBIENT_UNIF
+	AMBIENT_UNIF,
+	DIFFUSE_CONST_UNIF,
+	SPECULAR_CONST_UNIF,
+	EMISSION_CONST_UNIF,
+	NORMAL_CONST_UNIF
 } vert_uniform_type;
 
 typedef enum {
@@ -280,6 +284,10 @@ void reload_vertex_uniforms() {
 	if (ffp_vertex_params[NORMAL_MATRIX_UNIF]) {
 		ffp_vertex_params[LIGHTS_AMBIENTS_V_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "lights_ambients");
 		ffp_vertex_params[AMBIENT_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "ambient");
+		ffp_vertex_params[DIFFUSE_CONST_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "diff_const");
+		ffp_vertex_params[SPECULAR_CONST_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "spec_const");
+		ffp_vertex_params[EMISSION_CONST_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "emission_const");
+		ffp_vertex_params[NORMAL_CONST_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "normal_const");
 		if (ffp_vertex_params[LIGHTS_AMBIENTS_V_UNIF]) {
 			ffp_vertex_params[LIGHTS_DIFFUSES_V_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "lights_diffuses");
 			ffp_vertex_params[LIGHTS_SPECULARS_V_UNIF] = sceGxmProgramFindParameterByName(ffp_vertex_program, "lights_speculars");
@@ -485,6 +493,20 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 			}
 		}
 	}
+
+	if (mask.lights_num > 0) {
+		// Lighting attributes with no per-vertex data are read from uniforms on non-immediate draws
+		if (!attrs) {
+			for (int i = 0; i < 4; i++) {
+				if (!(ffp_vertex_attrib_state & (1 << (i + 3))) || ffp_vertex_stream_config[i + 3].stride == 0)
+					mask.const_attribs_mask |= (1 << i);
+			}
+			if (mask.const_attribs_mask & 0x08)
+				mask.fixed_mask &= ~(1 << 0);
+			draw_mask_state &= ~(mask.const_attribs_mask << 3);
+		}
+	} else // Lighting attributes are not read by the shader
+		draw_mask_state &= ~((1 << 3) | (1 << 4) | (1 << 5) | (1 << 6));
 #ifdef DISABLE_TEXTURE_COMBINER
 	if (ffp_mask.raw == mask.raw) { // Fixed function pipeline config didn't change
 #else
@@ -547,12 +569,12 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 		char fname[256];
 #ifndef DISABLE_TEXTURE_COMBINER
 #ifdef HAVE_HIGH_FFP_TEXUNITS
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX-%08X-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low, WVP_ON_GPU);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX-%08X-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low, WVP_ON_GPU);
 #else
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw, WVP_ON_GPU);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw, WVP_ON_GPU);
 #endif
 #else
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-0000000000000000-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, WVP_ON_GPU);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-0000000000000000-%d_v.gxp", SHADER_CACHE_MAGIC, mask.raw, WVP_ON_GPU);
 #endif
 		FILE *f = fopen(fname, "rb");
 		if (f) {
@@ -572,7 +594,7 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 
 			// Compiling the new shader
 			char vshader[8192];
-			sprintf(vshader, ffp_vert_src, mask.clip_planes_num, mask.num_textures, mask.has_colors, mask.lights_num, mask.shading_mode, mask.normalize, mask.fixed_mask, mask.pos_fixed_mask, WVP_ON_GPU);
+			sprintf(vshader, ffp_vert_src, mask.clip_planes_num, mask.num_textures, mask.has_colors, mask.lights_num, mask.shading_mode, mask.normalize, mask.fixed_mask, mask.pos_fixed_mask, WVP_ON_GPU, mask.const_attribs_mask);
 			uint32_t size = strlen(vshader);
 			SceGxmProgram *t = shark_compile_shader_extended(vshader, &size, SHARK_VERTEX_SHADER, compiler_opts, compiler_fastmath, compiler_fastprecision, compiler_fastint);
 #ifdef DUMP_SHADER_SOURCES
@@ -590,12 +612,12 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 			}
 #ifndef DISABLE_TEXTURE_COMBINER
 #ifdef HAVE_HIGH_FFP_TEXUNITS
-			sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX-%08X-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low, WVP_ON_GPU);
+			sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX-%08X-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low, WVP_ON_GPU);
 #else
-			sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw, WVP_ON_GPU);
+			sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw, WVP_ON_GPU);
 #endif
 #else
-			sprintf(fname, "ux0:data/shader_cache/v%d/%08X-0000000000000000-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, WVP_ON_GPU);
+			sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-0000000000000000-%d_v.cg", SHADER_CACHE_MAGIC, mask.raw, WVP_ON_GPU);
 #endif
 			// Saving shader source in filesystem cache
 			f = fopen(fname, "wb");
@@ -688,37 +710,45 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 		}
 		
 		if (mask.lights_num > 0) {	
-			param = sceGxmProgramFindParameterByName(ffp_vertex_program, "diff");
-			vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[3], sizeof(SceGxmVertexAttribute));
-			ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
-			ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
-			ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[3].stride;
-			ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
-			ffp_vertex_num_params++;
+			if (!(mask.const_attribs_mask & 0x01)) {
+				param = sceGxmProgramFindParameterByName(ffp_vertex_program, "diff");
+				vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[3], sizeof(SceGxmVertexAttribute));
+				ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
+				ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
+				ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[3].stride;
+				ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
+				ffp_vertex_num_params++;
+			}
 			
-			param = sceGxmProgramFindParameterByName(ffp_vertex_program, "spec");
-			vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[4], sizeof(SceGxmVertexAttribute));
-			ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
-			ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
-			ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[4].stride;
-			ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
-			ffp_vertex_num_params++;
+			if (!(mask.const_attribs_mask & 0x02)) {
+				param = sceGxmProgramFindParameterByName(ffp_vertex_program, "spec");
+				vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[4], sizeof(SceGxmVertexAttribute));
+				ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
+				ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
+				ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[4].stride;
+				ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
+				ffp_vertex_num_params++;
+			}
 			
-			param = sceGxmProgramFindParameterByName(ffp_vertex_program, "emission");
-			vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[5], sizeof(SceGxmVertexAttribute));
-			ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
-			ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
-			ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[5].stride;
-			ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
-			ffp_vertex_num_params++;
+			if (!(mask.const_attribs_mask & 0x04)) {
+				param = sceGxmProgramFindParameterByName(ffp_vertex_program, "emission");
+				vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[5], sizeof(SceGxmVertexAttribute));
+				ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
+				ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
+				ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[5].stride;
+				ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
+				ffp_vertex_num_params++;
+			}
 			
-			param = sceGxmProgramFindParameterByName(ffp_vertex_program, "normals");
-			vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[6], sizeof(SceGxmVertexAttribute));
-			ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
-			ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
-			ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[6].stride;
-			ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
-			ffp_vertex_num_params++;
+			if (!(mask.const_attribs_mask & 0x08)) {
+				param = sceGxmProgramFindParameterByName(ffp_vertex_program, "normals");
+				vgl_fast_memcpy(&ffp_vertex_attribute[ffp_vertex_num_params], &ffp_vertex_attrib_config[6], sizeof(SceGxmVertexAttribute));
+				ffp_vertex_attribute[ffp_vertex_num_params].streamIndex = ffp_vertex_num_params;
+				ffp_vertex_attribute[ffp_vertex_num_params].regIndex = sceGxmProgramParameterGetResourceIndex(param);
+				ffp_vertex_stream[ffp_vertex_num_params].stride = ffp_vertex_stream_config[6].stride;
+				ffp_vertex_stream[ffp_vertex_num_params].indexSource = SCE_GXM_INDEX_SOURCE_INDEX_16BIT;
+				ffp_vertex_num_params++;
+			}
 		}
 
 		// Vertex texture coordinates (Second pass)
@@ -756,12 +786,12 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 		char fname[256];
 #ifndef DISABLE_TEXTURE_COMBINER
 #ifdef HAVE_HIGH_FFP_TEXUNITS
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX-%08X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX-%08X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low);
 #else
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-%016llX_f.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-%016llX_f.gxp", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw);
 #endif
 #else
-		sprintf(fname, "ux0:data/shader_cache/v%d/%08X-0000000000000000_f.gxp", SHADER_CACHE_MAGIC, mask.raw);
+		sprintf(fname, "ux0:data/shader_cache/v%d/%016llX-0000000000000000_f.gxp", SHADER_CACHE_MAGIC, mask.raw);
 #endif
 		FILE *f = fopen(fname, "rb");
 		if (f) {
@@ -857,12 +887,12 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 			}
 #ifndef DISABLE_TEXTURE_COMBINER
 #ifdef HAVE_HIGH_FFP_TEXUNITS
-			sprintf(fname, "ux0:data/shader_cache/v%d-%08X-%016llX-%08X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low);
+			sprintf(fname, "ux0:data/shader_cache/v%d-%016llX-%016llX-%08X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw_high, cmb_mask.raw_low);
 #else
-			sprintf(fname, "ux0:data/shader_cache/v%d-%08X-%016X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw);
+			sprintf(fname, "ux0:data/shader_cache/v%d-%016llX-%016X_f.cg", SHADER_CACHE_MAGIC, mask.raw, cmb_mask.raw);
 #endif
 #else
-			sprintf(fname, "ux0:data/shader_cache/v%d-%08X-0000000000000000_f.cg", SHADER_CACHE_MAGIC, mask.raw);
+			sprintf(fname, "ux0:data/shader_cache/v%d-%016llX-0000000000000000_f.cg", SHADER_CACHE_MAGIC, mask.raw);
 #endif
 			// Saving shader source in filesystem cache
 			f = fopen(fname, "wb");
@@ -1012,6 +1042,14 @@ uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *str
 			if (ffp_vertex_params[AMBIENT_UNIF]) {
 				sceGxmSetUniformDataF(buffer, ffp_vertex_params[AMBIENT_UNIF], 0, 4, (const float *)&current_vtx.amb.r);
 			}
+			if (ffp_vertex_params[DIFFUSE_CONST_UNIF])
+				sceGxmSetUniformDataF(buffer, ffp_vertex_params[DIFFUSE_CONST_UNIF], 0, 4, (const float *)&current_vtx.diff.x);
+			if (ffp_vertex_params[SPECULAR_CONST_UNIF])
+				sceGxmSetUniformDataF(buffer, ffp_vertex_params[SPECULAR_CONST_UNIF], 0, 4, (const float *)&current_vtx.spec.x);
+			if (ffp_vertex_params[EMISSION_CONST_UNIF])
+				sceGxmSetUniformDataF(buffer, ffp_vertex_params[EMISSION_CONST_UNIF], 0, 4, (const float *)&current_vtx.emiss.x);
+			if (ffp_vertex_params[NORMAL_CONST_UNIF])
+				sceGxmSetUniformDataF(buffer, ffp_vertex_params[NORMAL_CONST_UNIF], 0, 3, (const float *)&current_vtx.nor.x);
 			if (ffp_vertex_params[LIGHTS_AMBIENTS_V_UNIF]) {
 				sceGxmSetUniformDataF(buffer, ffp_vertex_params[LIGHT_GLOBAL_AMBIENT_V_UNIF], 0, 4, (const float *)&light_global_ambient.r);
 				if (lights_aligned) {
@@ -1042,41 +1080,27 @@ void _glDrawArrays_FixedFunctionIMPL(GLsizei count) {
 
 	// Uploading textures on relative texture units
 	for (int i = 0; i < ffp_mask.num_textures; i++) {
-		sceGxmSetFragmentTexture(gxm_context, i, &texture_slots[texture_units[i].tex_id].gxm_tex);
+		setFragmentTexture(i, getTexture(texture_units[i].tex_id));
 	}
 
 	// Uploading vertex streams
 	int i, j = 0;
-	float *materials = NULL, *src_materials;
 	for (i = 0; i < FFP_VERTEX_ATTRIBS_NUM; i++) {
 		if (mask_state & (1 << i)) {
 			void *ptr;
 			if (ffp_vertex_attrib_vbo[i]) {
 				gpubuffer *gpu_buf = (gpubuffer *)ffp_vertex_attrib_vbo[i];
-				gpu_buf->used = GL_TRUE;
+				markBufferAsUsed(gpu_buf)
 				ptr = (uint8_t *)gpu_buf->ptr + ffp_vertex_attrib_offsets[i];
 			} else {
-				if (ffp_vertex_stream_config[i].stride == 0) { // Materials
-					if (!materials) {
-						materials = (float *)gpu_alloc_mapped_temp(12 * sizeof(float));
-						src_materials = (float *)&current_vtx.diff.x;
-					} else {
-						materials += 4;
-						src_materials += 4;
-					}
-					ptr = materials;
-					vgl_fast_memcpy(materials, src_materials, 4 * sizeof(float));
-				} else {
 #ifdef DRAW_SPEEDHACK
-					ptr = (void *)ffp_vertex_attrib_offsets[i];
+				ptr = (void *)ffp_vertex_attrib_offsets[i];
 #else
-					uint32_t size = count * ffp_vertex_stream_config[i].stride;
-					ptr = gpu_alloc_mapped_temp(size);
-					vgl_fast_memcpy(ptr, (void *)ffp_vertex_attrib_offsets[i], size);
+				ptr = upload_client_array((void *)ffp_vertex_attrib_offsets[i], count * ffp_vertex_stream_config[i].stride);
 #endif
-				}
 			}
-			sceGxmSetVertexStream(gxm_context, j++, ptr);
+			setVertexStream(j, ptr);
+			j++;
 		}
 	}
 }
@@ -1115,40 +1139,31 @@ void _glDrawElements_FixedFunctionIMPL(uint16_t *idx_buf, GLsizei count, uint32_
 
 	// Uploading textures on relative texture units
 	for (int i = 0; i < ffp_mask.num_textures; i++) {
-		sceGxmSetFragmentTexture(gxm_context, i, &texture_slots[texture_units[i].tex_id].gxm_tex);
+		setFragmentTexture(i, getTexture(texture_units[i].tex_id));
 	}
 
 	// Uploading vertex streams
-	float *materials = NULL, *src_materials;
 	for (int i = 0; i < attr_num; i++) {
 		void *ptr;
 		int attr_idx = attr_idxs[i];
 		if (ffp_vertex_attrib_vbo[attr_idx]) {
 			gpubuffer *gpu_buf = (gpubuffer *)ffp_vertex_attrib_vbo[attr_idx];
-			gpu_buf->used = GL_TRUE;
+			markBufferAsUsed(gpu_buf)
 			ptr = (uint8_t *)gpu_buf->ptr + ffp_vertex_attrib_offsets[attr_idx];
 		} else {
-			if (ffp_vertex_stream_config[attr_idx].stride == 0) { // Materials
-				if (!materials) {
-					materials = (float *)gpu_alloc_mapped_temp(12 * sizeof(float));
-					src_materials = (float *)&current_vtx.diff.x;
-				} else {
-					materials += 4;
-					src_materials += 4;
-				}
-				ptr = materials;
-				vgl_fast_memcpy(materials, src_materials, 4 * sizeof(float));
-			} else {
 #ifdef DRAW_SPEEDHACK
-				ptr = (void *)ffp_vertex_attrib_offsets[attr_idx];
+			ptr = (void *)ffp_vertex_attrib_offsets[attr_idx];
 #else
-				uint32_t size = top_idx * ffp_vertex_stream_config[attr_idx].stride;
-				ptr = gpu_alloc_mapped_temp(size);
-				vgl_fast_memcpy(ptr, (void *)ffp_vertex_attrib_offsets[attr_idx], size);
+			ptr = upload_client_array((void *)ffp_vertex_attrib_offsets[attr_idx], top_idx * ffp_vertex_stream_config[attr_idx].stride);
 #endif
-			}
 		}
-		sceGxmSetVertexStream(gxm_context, i, ptr);
+		setVertexStream(i, ptr);
+	}
+}
+
+void shift_ffp_vertex_attribs(GLint num) {
+	for (int i = 0; i < FFP_VERTEX_ATTRIBS_NUM; i++) {
+		ffp_vertex_attrib_offsets[i] += num * ffp_vertex_stream_config[i].stride;
 	}
 }
 
@@ -1743,6 +1758,8 @@ void glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) {
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
 	}
+
+	dirty_vert_unifs = GL_TRUE;
 }
 
 void glMaterialxv(GLenum face, GLenum pname, const GLfixed *params) {
@@ -1786,6 +1803,8 @@ void glMaterialxv(GLenum face, GLenum pname, const GLfixed *params) {
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
 	}
+
+	dirty_vert_unifs = GL_TRUE;
 }
 
 void glColor3f(GLfloat red, GLfloat green, GLfloat blue) {
@@ -1819,6 +1838,7 @@ void glColor3f(GLfloat red, GLfloat green, GLfloat blue) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -1853,6 +1873,7 @@ void glColor3fv(const GLfloat *v) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -1889,6 +1910,7 @@ void glColor3ub(GLubyte red, GLubyte green, GLubyte blue) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -1925,6 +1947,7 @@ void glColor3ubv(const GLubyte *c) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -1961,6 +1984,7 @@ void glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -1994,6 +2018,7 @@ void glColor4fv(const GLfloat *v) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -2029,6 +2054,7 @@ void glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -2065,6 +2091,7 @@ void glColor4ubv(const GLubyte *c) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -2108,6 +2135,7 @@ void glColor4x(GLfixed red, GLfixed green, GLfixed blue, GLfixed alpha) {
 			vgl_fast_memcpy(&current_vtx.diff.x, &current_vtx.clr.r, sizeof(float) * 4);
 			break;
 		}
+		dirty_vert_unifs = GL_TRUE;
 	}
 
 	dirty_frag_unifs = GL_TRUE;
@@ -2129,6 +2157,7 @@ void glNormal3f(GLfloat x, GLfloat y, GLfloat z) {
 	current_vtx.nor.x = x;
 	current_vtx.nor.y = y;
 	current_vtx.nor.z = z;
+	dirty_vert_unifs = GL_TRUE;
 }
 
 void glNormal3s(GLshort x, GLshort y, GLshort z) {
@@ -2155,6 +2184,7 @@ void glNormal3fv(const GLfloat *v) {
 	current_vtx.nor.x = v[0];
 	current_vtx.nor.y = v[1];
 	current_vtx.nor.z = v[2];
+	dirty_vert_unifs = GL_TRUE;
 }
 
 void glTexCoord2f(GLfloat s, GLfloat t) {
@@ -2274,12 +2304,12 @@ void glEnd(void) {
 	if (texture_units[1].enabled) { // Multitexture usage
 		ffp_vertex_attrib_state = 0xFF;
 		reload_ffp_shaders(legacy_mt_vertex_attrib_config, legacy_mt_vertex_stream_config);
-		sceGxmSetFragmentTexture(gxm_context, 0, &texture_slots[texture_units[0].tex_id].gxm_tex);
-		sceGxmSetFragmentTexture(gxm_context, 1, &texture_slots[texture_units[1].tex_id].gxm_tex);
+		setFragmentTexture(0, getTexture(texture_units[0].tex_id));
+		setFragmentTexture(1, getTexture(texture_units[1].tex_id));
 	} else if (texture_units[0].enabled) { // Texturing usage
 		ffp_vertex_attrib_state = 0x07;
 		reload_ffp_shaders(legacy_vertex_attrib_config, legacy_vertex_stream_config);
-		sceGxmSetFragmentTexture(gxm_context, 0, &texture_slots[texture_units[0].tex_id].gxm_tex);
+		setFragmentTexture(0, getTexture(texture_units[0].tex_id));
 	} else { // No texturing usage
 		ffp_vertex_attrib_state = 0x05;
 		reload_ffp_shaders(legacy_nt_vertex_attrib_config, legacy_nt_vertex_stream_config);
@@ -2290,37 +2320,46 @@ void glEnd(void) {
 
 	// Uploading vertex streams and performing the draw
 	for (int i = 0; i < ffp_vertex_num_params; i++) {
-		sceGxmSetVertexStream(gxm_context, i, legacy_pool);
+		setVertexStream(i, legacy_pool);
 	}
 
 	uint16_t *ptr;
 	uint32_t index_count;
 
-	// Get the index source
+	// Get the index source, clamping the draw if the progressive indices buffers could not be grown
+	uint32_t draw_count = reserveDefaultIndices(vertex_count);
+	if (draw_count > vertex_count)
+		draw_count = vertex_count;
 	switch (ffp_mode) {
 	case GL_QUADS:
 		ptr = default_quads_idx_ptr;
-		index_count = (vertex_count / 2) * 3;
+		index_count = (draw_count / 2) * 3;
 		break;
 	case GL_LINE_STRIP:
 		ptr = default_line_strips_idx_ptr;
-		index_count = (vertex_count - 1) * 2;
+		index_count = draw_count > 1 ? (draw_count - 1) * 2 : 0;
 		break;
 	case GL_LINE_LOOP:
-		ptr = gpu_alloc_mapped_temp(vertex_count * 2 * sizeof(uint16_t));
-		vgl_fast_memcpy(ptr, default_line_strips_idx_ptr, (vertex_count - 1) * 2 * sizeof(uint16_t));
-		ptr[(vertex_count - 1) * 2] = vertex_count - 1;
-		ptr[(vertex_count - 1) * 2 + 1] = 0;
+		if (draw_count < 2) {
+			ptr = default_idx_ptr;
+			index_count = 0;
+			break;
+		}
+		ptr = gpu_alloc_mapped_temp(draw_count * 2 * sizeof(uint16_t));
+		vgl_fast_memcpy(ptr, default_line_strips_idx_ptr, (draw_count - 1) * 2 * sizeof(uint16_t));
+		ptr[(draw_count - 1) * 2] = draw_count - 1;
+		ptr[(draw_count - 1) * 2 + 1] = 0;
 
-		index_count = vertex_count * 2;
+		index_count = draw_count * 2;
 		break;
 	default:
 		ptr = default_idx_ptr;
-		index_count = vertex_count;
+		index_count = draw_count;
 		break;
 	}
 
-	sceGxmDraw(gxm_context, prim, SCE_GXM_INDEX_FORMAT_U16, ptr, index_count);
+	if (index_count)
+		sceGxmDraw(gxm_context, prim, SCE_GXM_INDEX_FORMAT_U16, ptr, index_count);
 
 	// Moving legacy pool address offset
 	if (texture_units[1].enabled)
@@ -291,8 +291,15 @@ void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget,
 	}
 #endif
 
-	// Aliasing to make code more readable
-	texture *tex = &texture_slots[tex_id];
+	// Aliasing to make code more readable, names attached without being generated or bound get their slot here
+	if (!allocTextureChunk(tex_id)) {
+		SET_GL_ERROR(GL_OUT_OF_MEMORY)
+	}
+	texture *tex = getTexture(tex_id);
+
+	// Flushing any staged upload so that it can't overwrite rendered content later on
+	if (tex->staged_upload)
+		completeStagedUpload(tex);
 
 	// Extracting texture data
 	SceGxmTextureFormat fmt = sceGxmTextureGetFormat(&tex->gxm_tex);
@@ -532,7 +539,7 @@ void vglTexImageDepthBuffer(GLenum target) {
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_2D: {
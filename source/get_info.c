@@ -300,6 +300,9 @@ void glGetIntegerv(GLenum pname, GLint *data) {
 	case GL_ELEMENT_ARRAY_BUFFER_BINDING:
 		*data = cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER_BINDING:
+		*data = pixel_unpack_unit;
+		break;
 	case GL_MAX_ELEMENTS_INDICES:
 	case GL_MAX_ELEMENTS_VERTICES:
 		*data = 0x7FFFFFFF;
@@ -562,5 +565,5 @@ GLboolean glIsTexture(GLuint i) {
 	}
 #endif
 
-	return (i < TEXTURES_NUM && texture_slots[i].status != TEX_UNUSED);
+	return (i < TEXTURES_NUM && texture_slots[i / TEXTURES_CHUNK_SIZE] && getTexture(i)->status != TEX_UNUSED);
 }
@@ -63,6 +63,10 @@ framebuffer *in_use_framebuffer = NULL; // Currently in use framebuffer
 framebuffer *old_framebuffer = NULL; // Framebuffer used in last scene
 static GLboolean needs_end_scene = GL_FALSE; // Flag for gxm end scene requirement at scene reset
 static GLboolean needs_scene_reset = GL_TRUE; // Flag for when a scene reset is required
+static uint32_t scene_notification_value = 0; // Value written by the GPU once the last submitted scene is completed
+volatile uint32_t *scene_notification_addr; // Notification region slot written by the GPU at scenes completion
+static uint32_t transfer_notification_value = 0; // Value written by the GPU once the last submitted asynchronous transfer is completed
+volatile uint32_t *transfer_notification_addr; // Notification region slot written by the GPU at asynchronous transfers completion
 
 SceGxmContext *gxm_context; // sceGxm context instance
 GLenum vgl_error = GL_NO_ERROR; // Error returned by glGetError
@@ -92,6 +96,9 @@ void *frame_rt_purge_list[FRAME_PURGE_FREQ][FRAME_PURGE_RENDERTARGETS_LIST_SIZE]
 int frame_purge_idx = 0; // Index for currently populatable purge list
 int frame_elem_purge_idx = 0; // Index for currently populatable purge list element
 int frame_rt_purge_idx = 0; // Index for currently populatable purge list rendetarget
+uint32_t frame_counter = 0; // Number of frames submitted since application started
+SceGxmTexture bound_frag_textures[TEXTURE_IMAGE_UNITS_NUM]; // Fragment textures last set on sceGxm context
+const void *bound_vertex_streams[VERTEX_ATTRIBS_NUM]; // Vertex streams last set on sceGxm context
 static int frame_purge_clean_idx = 1;
 SceUID gc_mutex;
 static int gc_thread_priority = 0x10000100;
@@ -125,6 +132,8 @@ razor_results razor_metrics;
 GLboolean has_razor_live = GL_FALSE; // Flag for live metrics support with sceRazor
 #endif
 
+#define TRANSFER_POLLING_DELAY 100 // Delay in microseconds between two asynchronous transfer status checks
+
 #ifdef HAVE_SHARED_RENDERTARGETS
 #define MAX_RENDER_TARGETS_NUM 47 // Maximum amount of dedicated render targets usable for fbos
 #define MAX_SHARED_RT_SIZE 256 // Maximum  width value in pixels for shared rendertargets usage
@@ -335,6 +344,14 @@ void initGxm(void) {
 	sceGxmVshInitialize(&gxm_init_params);
 	gxm_initialized = GL_TRUE;
 
+	// Setting up the notification used to track scenes completion
+	scene_notification_addr = sceGxmGetNotificationRegion() + SCENE_NOTIFICATION_IDX;
+	*scene_notification_addr = scene_notification_value;
+
+	// Setting up the notification used to track asynchronous transfers completion
+	transfer_notification_addr = sceGxmGetNotificationRegion() + TRANSFER_NOTIFICATION_IDX;
+	*transfer_notification_addr = transfer_notification_value;
+
 #ifdef HAVE_DEVKIT
 	sceRazorGpuLiveSetMetricsGroup(SCE_RAZOR_GPU_LIVE_METRICS_GROUP_PBUFFER_USAGE);
 	has_razor_live = !sceRazorGpuLiveStart();
@@ -564,12 +581,40 @@ void waitRenderingDone(void) {
 }
 
 void sceneEnd(void) {
-	// Ends current gxm scene
-	sceGxmEndScene(gxm_context, NULL, NULL);
+	// Submitting any queued draw before the scene gets closed
+	vglFlushBakedObjectsQueue();
+
+	// Ends current gxm scene, making the GPU signal its completion once done
+	SceGxmNotification notification;
+	notification.address = scene_notification_addr;
+	notification.value = ++scene_notification_value;
+	stampSceneSubmission(notification.value);
+	sceGxmEndScene(gxm_context, NULL, &notification);
 	if (system_app_mode && vsync_interval)
 		sceDisplayWaitVblankStartMulti(vsync_interval);
 }
 
+void invalidateContextBinds(void) {
+	// Filling with values no valid texture or stream address can match
+	sceClibMemset(bound_frag_textures, 0xFF, sizeof(bound_frag_textures));
+	sceClibMemset(bound_vertex_streams, 0xFF, sizeof(bound_vertex_streams));
+}
+
+uint32_t getTransferNotification(SceGxmNotification *notification) {
+	// Zero is reserved to textures with no pending upload, so we skip it on wrap around
+	if (!++transfer_notification_value)
+		transfer_notification_value = 1;
+	notification->address = transfer_notification_addr;
+	notification->value = transfer_notification_value;
+	return transfer_notification_value;
+}
+
+void waitTransferNotification(uint32_t value) {
+	while (!isTransferNotificationSignaled(value)) {
+		sceKernelDelayThread(TRANSFER_POLLING_DELAY);
+	}
+}
+
 void sceneReset(void) {
 	if (in_use_framebuffer != active_write_fb || needs_scene_reset) {
 		needs_scene_reset = GL_FALSE;
@@ -591,6 +636,7 @@ void sceneReset(void) {
 		}
 
 		// Starting drawing scene
+		bindVisibilityBuffer();
 		is_rendering_display = !active_write_fb;
 		if (is_rendering_display) { // Default framebuffer is used
 			if (system_app_mode) {
@@ -665,6 +711,12 @@ void sceneReset(void) {
 #endif
 		}
 
+		// Restoring visibility test state for any active occlusion query
+		restoreVisibilityTest();
+
+		// Forcing textures and vertex streams binds on the new scene
+		invalidateContextBinds();
+
 		// Setting back current viewport if enabled cause sceGxm will reset it at sceGxmEndScene call
 		if (old_framebuffer != in_use_framebuffer) {
 			old_framebuffer = in_use_framebuffer;
@@ -726,6 +778,8 @@ void vglSwapBuffers(GLboolean has_commondialog) {
 	// Marking uniform values as dirty at each frame end just to be safe
 	dirty_frag_unifs = GL_TRUE;
 	dirty_vert_unifs = GL_TRUE;
+	resetClientArraysCacheBudget();
+	processStagedUploads();
 	
 #if defined(HAVE_RAZOR_INTERFACE) && !defined(HAVE_LIGHT_RAZOR)
 	if (!in_use_framebuffer) {
@@ -862,6 +916,8 @@ void vglSwapBuffers(GLboolean has_commondialog) {
 		}
 	}
 	needs_scene_reset = GL_TRUE;
+	frame_counter++;
+	purgeIdleBufferVersions();
 
 	// Starting garbage collector job
 #ifdef HAVE_SINGLE_THREADED_GC
@@ -871,6 +927,12 @@ void vglSwapBuffers(GLboolean has_commondialog) {
 #endif
 }
 
+uint32_t getSceneNotificationValue(GLboolean *is_submitted) {
+	// The currently open scene, if any, will be signaled with the next notification value
+	*is_submitted = !needs_end_scene;
+	return needs_end_scene ? scene_notification_value + 1 : scene_notification_value;
+}
+
 void glFinish(void) {
 	// Waiting for GPU to finish drawing jobs
 	sceGxmFinish(gxm_context);
@@ -36,6 +36,7 @@ static const struct {
 	{"glAlphaFuncx", (void *)glAlphaFuncx},
 	{"glAttachShader", (void *)glAttachShader},
 	{"glBegin", (void *)glBegin},
+	{"glBeginQuery", (void *)glBeginQuery},
 	{"glBindAttribLocation", (void *)glBindAttribLocation},
 	{"glBindBuffer", (void *)glBindBuffer},
 	{"glBindFramebuffer", (void *)glBindFramebuffer},
@@ -47,6 +48,7 @@ static const struct {
 	{"glBlendFunc", (void *)glBlendFunc},
 	{"glBlendFuncSeparate", (void *)glBlendFuncSeparate},
 	{"glBufferData", (void *)glBufferData},
+	{"glBufferStorage", (void *)glBufferStorage},
 	{"glBufferSubData", (void *)glBufferSubData},
 	{"glCallList", (void *)glCallList},
 	{"glCheckFramebufferStatus", (void *)glCheckFramebufferStatus},
@@ -58,6 +60,7 @@ static const struct {
 	{"glClearDepthx", (void *)glClearDepthx},
 	{"glClearStencil", (void *)glClearStencil},
 	{"glClientActiveTexture", (void *)glClientActiveTexture},
+	{"glClientWaitSync", (void *)glClientWaitSync},
 	{"glClipPlane", (void *)glClipPlane},
 	{"glClipPlanef", (void *)glClipPlanef},
 	{"glClipPlanex", (void *)glClipPlanex},
@@ -83,8 +86,10 @@ static const struct {
 	{"glDeleteFramebuffers", (void *)glDeleteFramebuffers},
 	{"glDeleteLists", (void *)glDeleteLists},
 	{"glDeleteProgram", (void *)glDeleteProgram},
+	{"glDeleteQueries", (void *)glDeleteQueries},
 	{"glDeleteRenderbuffers", (void *)glDeleteRenderbuffers},
 	{"glDeleteShader", (void *)glDeleteShader},
+	{"glDeleteSync", (void *)glDeleteSync},
 	{"glDeleteTextures", (void *)glDeleteTextures},
 	{"glDeleteVertexArrays", (void *)glDeleteVertexArrays},
 	{"glDepthFunc", (void *)glDepthFunc},
@@ -107,6 +112,8 @@ static const struct {
 	{"glEnableVertexAttribArray", (void *)glEnableVertexAttribArray},
 	{"glEnd", (void *)glEnd},
 	{"glEndList", (void *)glEndList},
+	{"glEndQuery", (void *)glEndQuery},
+	{"glFenceSync", (void *)glFenceSync},
 	{"glFinish", (void *)glFinish},
 	{"glFlush", (void *)glFlush},
 	{"glFlushMappedBufferRange", (void *)glFlushMappedBufferRange},
@@ -126,6 +133,7 @@ static const struct {
 	{"glGenerateMipmap", (void *)glGenerateMipmap},
 	{"glGenFramebuffers", (void *)glGenFramebuffers},
 	{"glGenLists", (void *)glGenLists},
+	{"glGenQueries", (void *)glGenQueries},
 	{"glGenRenderbuffers", (void *)glGenRenderbuffers},
 	{"glGenTextures", (void *)glGenTextures},
 	{"glGenVertexArrays", (void *)glGenVertexArrays},
@@ -135,6 +143,7 @@ static const struct {
 	{"glGetAttribLocation", (void *)glGetAttribLocation},
 	{"glGetBooleanv", (void *)glGetBooleanv},
 	{"glGetBufferParameteriv", (void *)glGetBufferParameteriv},
+	{"glGetCompressedTexImage", (void *)glGetCompressedTexImage},
 	{"glGetError", (void *)glGetError},
 	{"glGetFloatv", (void *)glGetFloatv},
 	{"glGetFramebufferAttachmentParameteriv", (void *)glGetFramebufferAttachmentParameteriv},
@@ -143,11 +152,16 @@ static const struct {
 	{"glGetProgramBinary", (void *)glGetProgramBinary},
 	{"glGetProgramInfoLog", (void *)glGetProgramInfoLog},
 	{"glGetProgramiv", (void *)glGetProgramiv},
+	{"glGetQueryiv", (void *)glGetQueryiv},
+	{"glGetQueryObjectiv", (void *)glGetQueryObjectiv},
+	{"glGetQueryObjectui64v", (void *)glGetQueryObjectui64v},
+	{"glGetQueryObjectuiv", (void *)glGetQueryObjectuiv},
 	{"glGetShaderInfoLog", (void *)glGetShaderInfoLog},
 	{"glGetShaderiv", (void *)glGetShaderiv},
 	{"glGetShaderSource", (void *)glGetShaderSource},
 	{"glGetString", (void *)glGetString},
 	{"glGetStringi", (void *)glGetStringi},
+	{"glGetSynciv", (void *)glGetSynciv},
 	{"glGetTexEnviv", (void *)glGetTexEnviv},
 	{"glGetUniformLocation", (void *)glGetUniformLocation},
 	{"glGetVertexAttribfv", (void *)glGetVertexAttribfv},
@@ -158,7 +172,9 @@ static const struct {
 	{"glIsEnabled", (void *)glIsEnabled},
 	{"glIsFramebuffer", (void *)glIsFramebuffer},
 	{"glIsProgram", (void *)glIsProgram},
+	{"glIsQuery", (void *)glIsQuery},
 	{"glIsRenderbuffer", (void *)glIsRenderbuffer},
+	{"glIsSync", (void *)glIsSync},
 	{"glIsTexture", (void *)glIsTexture},
 	{"glLightfv", (void *)glLightfv},
 	{"glLightModelfv", (void *)glLightModelfv},
@@ -203,6 +219,7 @@ static const struct {
 	{"glProgramBinary", (void *)glProgramBinary},
 	{"glPushAttrib", (void *)glPushAttrib},
 	{"glPushMatrix", (void *)glPushMatrix},
+	{"glQueryCounter", (void *)glQueryCounter},
 	{"glReadPixels", (void *)glReadPixels},
 	{"glRectf", (void *)glRectf},
 	{"glReleaseShaderCompiler", (void *)glReleaseShaderCompiler},
@@ -277,6 +294,7 @@ static const struct {
 	{"glVertexAttribPointer", (void *)glVertexAttribPointer},
 	{"glVertexPointer", (void *)glVertexPointer},
 	{"glViewport", (void *)glViewport},
+	{"glWaitSync", (void *)glWaitSync},
 	// *glu
 	{"gluBuild2DMipmaps", (void *)gluBuild2DMipmaps},
 	{"gluLookAt", (void *)gluLookAt},
@@ -296,6 +314,11 @@ static const struct {
 	{"vglBindPackedAttribLocation", (void *)vglBindPackedAttribLocation},
 	{"vglVertexAttribPointer", (void *)vglVertexAttribPointer},
 	{"vglVertexAttribPointerMapped", (void *)vglVertexAttribPointerMapped},
+	{"vglBakeObjects", (void *)vglBakeObjects},
+	{"vglDeleteBakedObjects", (void *)vglDeleteBakedObjects},
+	{"vglDrawBakedObjects", (void *)vglDrawBakedObjects},
+	{"vglEnableBakedObjectsQueue", (void *)vglEnableBakedObjectsQueue},
+	{"vglFlushBakedObjectsQueue", (void *)vglFlushBakedObjectsQueue},
 	{"vglAlloc", (void *)vglAlloc},
 	{"vglCalloc", (void *)vglCalloc},
 	{"vglEnd", (void *)vglEnd},
@@ -305,6 +328,7 @@ static const struct {
 	{"vglGetProcAddress", (void *)vglGetProcAddress},
 	{"vglGetShaderBinary", (void *)vglGetShaderBinary},
 	{"vglGetTexDataPointer", (void *)vglGetTexDataPointer},
+	{"vglGetTexResidentLevel", (void *)vglGetTexResidentLevel},
 	{"vglInit", (void *)vglInit},
 	{"vglInitExtended", (void *)vglInitExtended},
 	{"vglInitWithCustomSizes", (void *)vglInitWithCustomSizes},
@@ -319,6 +343,8 @@ static const struct {
 	{"vglSetDisplayCallback", (void *)vglSetDisplayCallback},
 	{"vglSetFragmentBufferSize", (void *)vglSetFragmentBufferSize},
 	{"vglSetParamBufferSize", (void *)vglSetParamBufferSize},
+	{"vglSetTextureCache", (void *)vglSetTextureCache},
+	{"vglSetTextureUploadBudget", (void *)vglSetTextureUploadBudget},
 	{"vglSetUSSEBufferSize", (void *)vglSetUSSEBufferSize},
 	{"vglSetVDMBufferSize", (void *)vglSetVDMBufferSize},
 	{"vglSetVertexBufferSize", (void *)vglSetVertexBufferSize},
@@ -327,6 +353,7 @@ static const struct {
 	{"vglSetupRuntimeShaderCompiler", (void *)vglSetupRuntimeShaderCompiler},
 	{"vglSwapBuffers", (void *)vglSwapBuffers},
 	{"vglTexImageDepthBuffer", (void *)vglTexImageDepthBuffer},
+	{"vglTexMipStreaming", (void *)vglTexMipStreaming},
 	{"vglUseCachedMem", (void *)vglUseCachedMem},
 	{"vglUseTripleBuffering", (void *)vglUseTripleBuffering},
 	{"vglUseVram", (void *)vglUseVram},
@@ -0,0 +1,491 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * queries.c:
+ * Implementation for query objects related functions
+ */
+
+#include "shared.h"
+
+#define VISIBILITY_BUFFER_STRIDE (MAX_OCCLUSION_QUERIES_NUM * sizeof(uint32_t)) // Visibility buffer size in bytes per GPU core
+#define QUERY_POLLING_DELAY 100 // Delay in microseconds between two query status checks
+#define SCENE_TIMESTAMPS_NUM 256 // Number of scenes tracked for timer queries
+#define TIMER_THREAD_PRIORITY SCE_KERNEL_HIGHEST_PRIORITY_USER // Priority of the thread timestamping scenes completion
+#define TIMER_THREAD_STACK_SIZE 0x1000 // Stack size of the thread timestamping scenes completion
+
+// Query object struct
+typedef struct {
+	GLenum target; // Target the query got first bound to
+	int32_t vis_idx; // Visibility index used by occlusion queries
+	uint32_t value; // Scene notification value signaling result availability
+	uint32_t start_value; // Scene notification value signaling the beginning of a timer query
+	GLboolean is_pending; // Whether the query has a result not yet retrieved from the GPU
+	GLuint64 result; // Last retrieved query result
+} query;
+
+static void *visibility_buffer = NULL; // Visibility buffer used for occlusion queries
+static uint32_t visibility_idx_used[MAX_OCCLUSION_QUERIES_NUM / 32]; // Bitmask of the in use visibility indices
+static query *occlusion_query = NULL; // Currently active occlusion query
+static query *timer_query = NULL; // Currently active timer query
+
+// Scene timestamps struct
+typedef struct {
+	volatile uint32_t value; // Scene notification value signaling the scene completion
+	volatile SceUInt64 submit_time; // Time in microseconds the scene got submitted to the GPU
+	volatile SceUInt64 complete_time; // Time in microseconds the scene got seen as completed (0 if not yet completed)
+} scene_timestamp;
+
+static scene_timestamp scene_timestamps[SCENE_TIMESTAMPS_NUM]; // Timestamps of the last submitted scenes
+static SceUID timer_thread = 0; // Thread timestamping scenes completion
+static SceUID timer_sema; // Semaphore used to wake the timer thread up
+static volatile uint32_t timer_target_value = 0; // Scene notification value the timer thread has to wait for
+static volatile GLboolean timer_thread_exit = GL_FALSE; // Whether the timer thread has to terminate
+
+/*
+ * The GPU can't write timestamps on its own, so scenes completion gets timestamped by a thread polling
+ * the scene notification while timer queries are pending. Resulting timings have a granularity of a whole
+ * scene and an accuracy bounded by QUERY_POLLING_DELAY. The thread sleeps for most of its lifetime, so
+ * it runs at a high priority to get scheduled as soon as its polling delay expires instead of waiting
+ * for the rendering threads to yield, which would stamp several scenes with the same late time.
+ */
+static int timer_thread_func(SceSize args, void *argp) {
+	uint32_t last_value = *scene_notification_addr;
+	while (!timer_thread_exit) {
+		sceKernelWaitSema(timer_sema, 1, NULL);
+		while (!timer_thread_exit) {
+			uint32_t cur_value = *scene_notification_addr;
+			if (cur_value != last_value) {
+				SceUInt64 t = sceKernelGetProcessTimeWide();
+				while (last_value != cur_value) {
+					last_value++;
+					scene_timestamp *ts = &scene_timestamps[last_value % SCENE_TIMESTAMPS_NUM];
+					if (ts->value == last_value)
+						ts->complete_time = t;
+				}
+			}
+			if ((int32_t)(last_value - timer_target_value) >= 0)
+				break;
+			sceKernelDelayThread(QUERY_POLLING_DELAY);
+		}
+	}
+	return 0;
+}
+
+// Makes the timer thread timestamp scenes up to the one signaling a given notification value
+static void request_scene_timestamps(uint32_t value) {
+	if (!timer_thread) {
+		timer_sema = sceKernelCreateSema("Timer Queries Sema", 0, 0, 1, NULL);
+		timer_thread = sceKernelCreateThread("Timer Queries", &timer_thread_func, TIMER_THREAD_PRIORITY, TIMER_THREAD_STACK_SIZE, 0, 0, NULL);
+		sceKernelStartThread(timer_thread, 0, NULL);
+	}
+	if ((int32_t)(value - timer_target_value) > 0)
+		timer_target_value = value;
+	sceKernelSignalSema(timer_sema, 1);
+}
+
+static inline scene_timestamp *get_scene_timestamp(uint32_t value) {
+	scene_timestamp *ts = &scene_timestamps[value % SCENE_TIMESTAMPS_NUM];
+	return ts->value == value ? ts : NULL;
+}
+
+// Waits for the GPU to complete the scene signaling a given notification value
+static void wait_scene_notification(uint32_t value) {
+	if (isSceneNotificationSignaled(value))
+		return;
+
+	// Submitting the scene signaling the notification if it's still being recorded
+	GLboolean is_submitted;
+	if (getSceneNotificationValue(&is_submitted) == value && !is_submitted)
+		glFlush();
+	while (!isSceneNotificationSignaled(value)) {
+		sceKernelDelayThread(QUERY_POLLING_DELAY);
+	}
+}
+
+static int32_t reserve_visibility_idx(void) {
+	for (int i = 0; i < MAX_OCCLUSION_QUERIES_NUM / 32; i++) {
+		if (visibility_idx_used[i] != 0xFFFFFFFF) {
+			int32_t bit = __builtin_ctz(~visibility_idx_used[i]);
+			visibility_idx_used[i] |= (1U << bit);
+			return i * 32 + bit;
+		}
+	}
+	return -1;
+}
+
+static inline void release_visibility_idx(int32_t idx) {
+	visibility_idx_used[idx / 32] &= ~(1U << (idx % 32));
+}
+
+// Gathers the result of an occlusion query summing up the counters of all GPU cores
+static GLuint64 read_visibility_result(query *q) {
+	GLuint64 res = 0;
+	for (int i = 0; i < SCE_GXM_GPU_CORE_COUNT; i++) {
+		res += ((volatile uint32_t *)((uint8_t *)visibility_buffer + i * VISIBILITY_BUFFER_STRIDE))[q->vis_idx];
+	}
+	if (q->target != GL_SAMPLES_PASSED)
+		res = res ? GL_TRUE : GL_FALSE;
+	return res;
+}
+
+// Gathers the result of a timer query in nanoseconds
+static GLuint64 read_timer_result(query *q) {
+	scene_timestamp *end = get_scene_timestamp(q->value);
+	if (!end)
+		return 0;
+	if (q->target == GL_TIMESTAMP)
+		return end->complete_time * 1000;
+
+	// Work can't start on GPU before the previous scene completed nor before its scene got submitted
+	SceUInt64 start_time = 0;
+	scene_timestamp *prev = get_scene_timestamp(q->start_value);
+	scene_timestamp *first = get_scene_timestamp(q->start_value + 1);
+	if (prev)
+		start_time = prev->complete_time;
+	if (first && first->submit_time > start_time)
+		start_time = first->submit_time;
+	return end->complete_time > start_time ? (end->complete_time - start_time) * 1000 : 0;
+}
+
+static GLboolean is_query_result_available(query *q) {
+	if (!isSceneNotificationSignaled(q->value))
+		return GL_FALSE;
+	if (q->target == GL_TIME_ELAPSED || q->target == GL_TIMESTAMP) {
+		scene_timestamp *ts = get_scene_timestamp(q->value);
+		return (!ts || ts->complete_time) ? GL_TRUE : GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+static void retrieve_query_result(query *q) {
+	if (q->is_pending && is_query_result_available(q)) {
+		q->result = (q->target == GL_TIME_ELAPSED || q->target == GL_TIMESTAMP) ? read_timer_result(q) : read_visibility_result(q);
+		q->is_pending = GL_FALSE;
+	}
+}
+
+// Reads a query object parameter, returns GL_FALSE if no value has to be written to the caller
+static GLboolean get_query_object(GLuint id, GLenum pname, GLuint64 *res) {
+	query *q = (query *)id;
+#ifndef SKIP_ERROR_HANDLING
+	if (!q || q == occlusion_query || q == timer_query || !q->target) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, GL_FALSE)
+	}
+#endif
+	switch (pname) {
+	case GL_QUERY_RESULT_AVAILABLE:
+		retrieve_query_result(q);
+		*res = q->is_pending ? GL_FALSE : GL_TRUE;
+		break;
+	case GL_QUERY_RESULT_NO_WAIT:
+		// Results not yet available leave the caller's value untouched
+		retrieve_query_result(q);
+		if (q->is_pending)
+			return GL_FALSE;
+		*res = q->result;
+		break;
+	case GL_QUERY_RESULT:
+		if (q->is_pending) {
+			wait_scene_notification(q->value);
+			while (!is_query_result_available(q)) {
+				sceKernelDelayThread(QUERY_POLLING_DELAY);
+			}
+		}
+		retrieve_query_result(q);
+		*res = q->result;
+		break;
+	default:
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_ENUM, GL_FALSE, pname)
+	}
+	return GL_TRUE;
+}
+
+void stampSceneSubmission(uint32_t value) {
+	if (timer_thread) {
+		scene_timestamp *ts = &scene_timestamps[value % SCENE_TIMESTAMPS_NUM];
+		ts->complete_time = 0;
+		ts->submit_time = sceKernelGetProcessTimeWide();
+		ts->value = value;
+	}
+}
+
+void stopTimerQueries(void) {
+	if (timer_thread) {
+		timer_thread_exit = GL_TRUE;
+		sceKernelSignalSema(timer_sema, 1);
+		sceKernelWaitThreadEnd(timer_thread, NULL, NULL);
+		sceKernelDeleteThread(timer_thread);
+		sceKernelDeleteSema(timer_sema);
+		timer_thread = 0;
+		timer_thread_exit = GL_FALSE;
+	}
+}
+
+void bindVisibilityBuffer(void) {
+	if (visibility_buffer)
+		sceGxmSetVisibilityBuffer(gxm_context, visibility_buffer, VISIBILITY_BUFFER_STRIDE);
+}
+
+void restoreVisibilityTest(void) {
+	if (!visibility_buffer)
+		return;
+	if (occlusion_query) {
+		SceGxmVisibilityTestOp op = occlusion_query->target == GL_SAMPLES_PASSED ? SCE_GXM_VISIBILITY_TEST_OP_INCREMENT : SCE_GXM_VISIBILITY_TEST_OP_SET;
+		sceGxmSetFrontVisibilityTestIndex(gxm_context, occlusion_query->vis_idx);
+		sceGxmSetBackVisibilityTestIndex(gxm_context, occlusion_query->vis_idx);
+		sceGxmSetFrontVisibilityTestOp(gxm_context, op);
+		sceGxmSetBackVisibilityTestOp(gxm_context, op);
+		sceGxmSetFrontVisibilityTestEnable(gxm_context, SCE_GXM_VISIBILITY_TEST_ENABLED);
+		sceGxmSetBackVisibilityTestEnable(gxm_context, SCE_GXM_VISIBILITY_TEST_ENABLED);
+	} else {
+		sceGxmSetFrontVisibilityTestEnable(gxm_context, SCE_GXM_VISIBILITY_TEST_DISABLED);
+		sceGxmSetBackVisibilityTestEnable(gxm_context, SCE_GXM_VISIBILITY_TEST_DISABLED);
+	}
+}
+
+/*
+ * ------------------------------
+ * - IMPLEMENTATION STARTS HERE -
+ * ------------------------------
+ */
+
+void glGenQueries(GLsizei n, GLuint *ids) {
+#ifndef SKIP_ERROR_HANDLING
+	if (n < 0) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+#endif
+
+	// Allocating the visibility buffer the first time queries get used
+	if (!visibility_buffer && n) {
+		visibility_buffer = gpu_alloc_mapped_aligned(MEM_ALIGNMENT, VISIBILITY_BUFFER_STRIDE * SCE_GXM_GPU_CORE_COUNT, VGL_MEM_RAM);
+		if (!visibility_buffer) {
+			SET_GL_ERROR(GL_OUT_OF_MEMORY)
+		}
+		sceClibMemset(visibility_buffer, 0, VISIBILITY_BUFFER_STRIDE * SCE_GXM_GPU_CORE_COUNT);
+
+		// The visibility buffer is bound at scene begin, so we submit the scene being recorded, if any
+		GLboolean is_submitted;
+		getSceneNotificationValue(&is_submitted);
+		if (!is_submitted)
+			glFlush();
+	}
+
+	for (int i = 0; i < n; i++) {
+		query *q = (query *)vglMalloc(sizeof(query));
+#ifndef SKIP_ERROR_HANDLING
+		if (!q) {
+			SET_GL_ERROR(GL_OUT_OF_MEMORY)
+		}
+#endif
+		sceClibMemset(q, 0, sizeof(query));
+		q->vis_idx = -1;
+		ids[i] = (GLuint)q;
+	}
+}
+
+void glDeleteQueries(GLsizei n, const GLuint *ids) {
+#ifndef SKIP_ERROR_HANDLING
+	if (n < 0) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+#endif
+	for (int i = 0; i < n; i++) {
+		if (ids[i]) {
+			query *q = (query *)ids[i];
+			if (q == occlusion_query) {
+				occlusion_query = NULL;
+				restoreVisibilityTest();
+			}
+			if (q == timer_query)
+				timer_query = NULL;
+
+			// Visibility index can be reused only once the GPU is done writing on it
+			if (q->vis_idx >= 0) {
+				if (q->is_pending)
+					wait_scene_notification(q->value);
+				release_visibility_idx(q->vis_idx);
+			}
+			vglFree(q);
+		}
+	}
+}
+
+GLboolean glIsQuery(GLuint id) {
+	return id ? GL_TRUE : GL_FALSE;
+}
+
+void glBeginQuery(GLenum target, GLuint id) {
+	query *q = (query *)id;
+	switch (target) {
+	case GL_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED_CONSERVATIVE:
+#ifndef SKIP_ERROR_HANDLING
+		if (!q || occlusion_query || (q->target && q->target != target)) {
+			SET_GL_ERROR(GL_INVALID_OPERATION)
+		}
+#endif
+		if (q->vis_idx < 0) {
+			q->vis_idx = reserve_visibility_idx();
+#ifndef SKIP_ERROR_HANDLING
+			if (q->vis_idx < 0) {
+				SET_GL_ERROR(GL_OUT_OF_MEMORY)
+			}
+#endif
+		} else if (q->is_pending)
+			wait_scene_notification(q->value);
+
+		// Resetting visibility counters for the query
+		for (int i = 0; i < SCE_GXM_GPU_CORE_COUNT; i++) {
+			((uint32_t *)((uint8_t *)visibility_buffer + i * VISIBILITY_BUFFER_STRIDE))[q->vis_idx] = 0;
+		}
+		q->target = target;
+		q->is_pending = GL_FALSE;
+		occlusion_query = q;
+		restoreVisibilityTest();
+		break;
+	case GL_TIME_ELAPSED:
+#ifndef SKIP_ERROR_HANDLING
+		if (!q || timer_query || (q->target && q->target != target)) {
+			SET_GL_ERROR(GL_INVALID_OPERATION)
+		}
+#endif
+		// Timing starts once the scene preceding the first one holding the timed commands is completed
+		{
+			GLboolean is_submitted;
+			q->start_value = getSceneNotificationValue(&is_submitted);
+			if (!is_submitted)
+				q->start_value--;
+			request_scene_timestamps(q->start_value);
+		}
+		q->target = target;
+		q->is_pending = GL_FALSE;
+		timer_query = q;
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	}
+}
+
+void glEndQuery(GLenum target) {
+	query *q;
+	switch (target) {
+	case GL_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED_CONSERVATIVE:
+#ifndef SKIP_ERROR_HANDLING
+		if (!occlusion_query || occlusion_query->target != target) {
+			SET_GL_ERROR(GL_INVALID_OPERATION)
+		}
+#endif
+		q = occlusion_query;
+		occlusion_query = NULL;
+		restoreVisibilityTest();
+		break;
+	case GL_TIME_ELAPSED:
+#ifndef SKIP_ERROR_HANDLING
+		if (!timer_query) {
+			SET_GL_ERROR(GL_INVALID_OPERATION)
+		}
+#endif
+		q = timer_query;
+		timer_query = NULL;
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	}
+
+	// Result will be available once the GPU completes the scene currently being recorded
+	GLboolean is_submitted;
+	q->value = getSceneNotificationValue(&is_submitted);
+	q->is_pending = GL_TRUE;
+	if (target == GL_TIME_ELAPSED)
+		request_scene_timestamps(q->value);
+}
+
+void glQueryCounter(GLuint id, GLenum target) {
+	query *q = (query *)id;
+#ifndef SKIP_ERROR_HANDLING
+	if (target != GL_TIMESTAMP) {
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	} else if (!q || q == occlusion_query || q == timer_query || (q->target && q->target != target)) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+#endif
+
+	// Timestamp is taken once the GPU completes the scene currently being recorded
+	GLboolean is_submitted;
+	q->target = target;
+	q->value = getSceneNotificationValue(&is_submitted);
+	q->is_pending = GL_TRUE;
+	request_scene_timestamps(q->value);
+}
+
+void glGetQueryiv(GLenum target, GLenum pname, GLint *params) {
+	switch (target) {
+	case GL_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED:
+	case GL_ANY_SAMPLES_PASSED_CONSERVATIVE:
+		switch (pname) {
+		case GL_CURRENT_QUERY:
+			*params = (occlusion_query && occlusion_query->target == target) ? (GLint)occlusion_query : 0;
+			break;
+		case GL_QUERY_COUNTER_BITS:
+			*params = 32;
+			break;
+		default:
+			SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
+		}
+		break;
+	case GL_TIME_ELAPSED:
+	case GL_TIMESTAMP:
+		switch (pname) {
+		case GL_CURRENT_QUERY:
+			*params = (target == GL_TIME_ELAPSED && timer_query) ? (GLint)timer_query : 0;
+			break;
+		case GL_QUERY_COUNTER_BITS:
+			*params = 64;
+			break;
+		default:
+			SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
+		}
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	}
+}
+
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) {
+	GLuint64 res;
+	if (get_query_object(id, pname, &res))
+		*params = res;
+}
+
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+	GLuint64 res;
+	if (get_query_object(id, pname, &res))
+		*params = res > 0xFFFFFFFF ? 0xFFFFFFFF : res;
+}
+
+void glGetQueryObjectiv(GLuint id, GLenum pname, GLint *params) {
+	GLuint64 res;
+	if (get_query_object(id, pname, &res))
+		*params = res > 0x7FFFFFFF ? 0x7FFFFFFF : res;
+}
@@ -3,6 +3,12 @@
 	0x01 = Normal
 	0x02 = Tex0
 	0x04 = Tex1
+
+	Constant Attributes Masks:
+	0x01 = Diffuse
+	0x02 = Specular
+	0x04 = Emission
+	0x08 = Normal
 */
 
 const char *ffp_vert_src =
@@ -15,6 +21,7 @@ R"(#define clip_planes_num %d
 #define fixed_mode_mask %d
 #define fixed_mode_pos %d
 #define calculate_wvp %d
+#define const_attribs_mask %d
 
 #define GLFixedToFloat(fx) (float(bit_cast<short2>(fx).y + (bit_cast<unsigned short2>(fx).x * (1.0f / 65536.0f))))
 #define GLFixed2ToFloat2(fx2) (float2(GLFixedToFloat(fx2.x), GLFixedToFloat(fx2.y)))
@@ -83,11 +90,19 @@ void main(
 	float4 color, // We re-use this for ambient values when lighting is on
 #endif
 #if lights_num > 0
+#if (const_attribs_mask & 0x01) == 0
 	float4 diff,
+#endif
+#if (const_attribs_mask & 0x02) == 0
 	float4 spec,
+#endif
+#if (const_attribs_mask & 0x04) == 0
 	float4 emission,
+#endif
+#if (const_attribs_mask & 0x08) == 0
 	float3 normals,
 #endif
+#endif
 #if num_textures > 0
 	float2 out vTexcoord : TEXCOORD0,
 #if num_textures > 1
@@ -113,6 +128,20 @@ void main(
 #if has_colors == 0 && lights_num > 0
 	uniform float4 ambient,
 #endif
+#if lights_num > 0
+#if (const_attribs_mask & 0x01) == 0x01
+	uniform float4 diff_const,
+#endif
+#if (const_attribs_mask & 0x02) == 0x02
+	uniform float4 spec_const,
+#endif
+#if (const_attribs_mask & 0x04) == 0x04
+	uniform float4 emission_const,
+#endif
+#if (const_attribs_mask & 0x08) == 0x08
+	uniform float3 normal_const,
+#endif
+#endif
 #if clip_planes_num > 0 || lights_num > 0 || calculate_wvp == 1
 	uniform float4x4 modelview,
 #endif
@@ -148,6 +177,18 @@ void main(
 	
 	// Lighting
 #if lights_num > 0
+#if (const_attribs_mask & 0x01) == 0x01
+	float4 diff = diff_const;
+#endif
+#if (const_attribs_mask & 0x02) == 0x02
+	float4 spec = spec_const;
+#endif
+#if (const_attribs_mask & 0x04) == 0x04
+	float4 emission = emission_const;
+#endif
+#if (const_attribs_mask & 0x08) == 0x08
+	float3 normals = normal_const;
+#endif
 #if (fixed_mode_mask & 0x01) == 0x01
 	normals = GLFixed3ToFloat3(normals);
 #endif
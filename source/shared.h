@@ -30,6 +30,7 @@
 
 // Internal constants
 #define TEXTURES_NUM 16384 // Available textures
+#define TEXTURES_CHUNK_SIZE 256 // Number of texture slots allocated at once, must be a power of two
 #define TEXTURE_IMAGE_UNITS_NUM 16 // Available texture image units
 #ifdef HAVE_HIGH_FFP_TEXUNITS
 #define TEXTURE_COORDS_NUM 3 // Available texture coords sets for multitexturing with ffp
@@ -59,7 +60,11 @@
 #define LEGACY_MT_VERTEX_STRIDE 26 // Vertex stride for GL1 immediate draw pipeline with multitexturing
 #define LEGACY_NT_VERTEX_STRIDE 22 // Vertex stride for GL1 immediate draw pipeline without texturing
 #define MAX_LIGHTS_NUM 8 // Maximum number of allowed light sources for ffp
-#define MAX_IDX_NUMBER 0xC000 // Maximum allowed number of indices per draw call for glDrawArrays
+#define MAX_IDX_NUMBER 0xC000 // Initial number of vertices addressable through the progressive indices buffers
+#define MAX_DRAW_CHUNK_VERTICES 0xFFFC // Maximum number of vertices drawn with a single sceGxm draw call by glDrawArrays
+#define SCENE_NOTIFICATION_IDX 511 // Notification region slot used to track scenes completion
+#define TRANSFER_NOTIFICATION_IDX 510 // Notification region slot used to track asynchronous transfers completion
+#define MAX_OCCLUSION_QUERIES_NUM 1024 // Maximum number of occlusion queries with a reserved visibility index
 
 // Internal constants set in bootup phase
 extern int DISPLAY_WIDTH; // Display width in pixels
@@ -82,6 +87,7 @@ extern float DISPLAY_HEIGHT_FLOAT; // Display height in pixels (float)
 #include <psp2/kernel/dmac.h>
 #include <psp2/kernel/processmgr.h>
 #include <psp2/kernel/sysmem.h>
+#include <psp2/kernel/threadmgr.h>
 #include <psp2/razor_capture.h>
 #include <psp2/razor_hud.h>
 #include <psp2/rtc.h>
@@ -91,18 +97,21 @@ extern float DISPLAY_HEIGHT_FLOAT; // Display height in pixels (float)
 #include "vitaGL.h"
 
 #include "utils/atitc_utils.h"
+#include "utils/cache_utils.h"
 #include "utils/eac_utils.h"
 #include "utils/etc1_utils.h"
 #include "utils/gpu_utils.h"
 #include "utils/gxm_utils.h"
+#include "utils/job_utils.h"
 #include "utils/math_utils.h"
 #include "utils/mem_utils.h"
+#include "utils/transcode_utils.h"
 
 #include "texture_callbacks.h"
 
 // Fixed-function pipeline shader cache settings
 #ifndef DISABLE_FS_SHADER_CACHE
-#define SHADER_CACHE_MAGIC 16 // This must be increased whenever ffp shader sources or shader mask/combiner mask changes
+#define SHADER_CACHE_MAGIC 17 // This must be increased whenever ffp shader sources or shader mask/combiner mask changes
 //#define DUMP_SHADER_SOURCES // Enable this flag to dump shader sources inside shader cache
 #endif
 
@@ -427,8 +436,30 @@ typedef struct {
 	vglMemType type;
 	GLboolean used;
 	GLboolean mapped;
+	void *idx_cache; // Converted index lists for non native primitives
+	void *short_ptr; // Narrowed 16 bit copy of a 32 bit element buffer
+	uint32_t top_idx; // Highest index value plus one of a 32 bit element buffer (0 if not yet computed)
+	GLboolean short_used; // Whether the narrowed copy has been read by a draw call
+	int32_t dirty_start; // Start of the range written since the narrowed copy was last updated
+	int32_t dirty_end; // End of the range written since the narrowed copy was last updated (0 if none)
+	uint32_t last_frame; // Frame number of the last draw call reading the buffer
+	void *versions; // Retired versions of the buffer content available for orphaning
+	void *versions_next; // Next buffer in the list of buffers holding retired versions
+	GLbitfield map_access; // Access flags of the current mapping
+	uint32_t map_offset; // Offset in bytes of the current mapping
+	uint32_t map_length; // Size in bytes of the current mapping
+	GLbitfield storage_flags; // Flags of the immutable storage set with glBufferStorage
+	GLboolean immutable; // Whether the buffer storage is immutable
 } gpubuffer;
 
+// Persistent buffers storage is never relocated and can be written at any time by the application
+#define isBufferPersistent(x) (x->storage_flags & GL_MAP_PERSISTENT_BIT)
+
+// Macro to mark a buffer as read by a draw call
+#define markBufferAsUsed(x) \
+	x->used = GL_TRUE; \
+	x->last_frame = frame_counter;
+
 // VAO struct
 typedef struct {
 	uint32_t index_array_unit;
@@ -661,6 +692,21 @@ extern void *frame_rt_purge_list[FRAME_PURGE_FREQ][FRAME_PURGE_RENDERTARGETS_LIS
 extern int frame_purge_idx; // Index for currently populatable purge list
 extern int frame_elem_purge_idx; // Index for currently populatable purge list element
 extern int frame_rt_purge_idx; // Index for currently populatable purge list rendertarget
+extern uint32_t frame_counter; // Number of frames submitted since application started
+extern volatile uint32_t *scene_notification_addr; // Notification region slot written by the GPU at scenes completion
+
+// Macro to check if the GPU completed all the scenes submitted up to the one signaling a given notification value
+#define isSceneNotificationSignaled(x) ((int32_t)(*scene_notification_addr - (x)) >= 0)
+extern volatile uint32_t *transfer_notification_addr; // Notification region slot written by the GPU at asynchronous transfers completion
+
+// Macro to check if the GPU completed all the asynchronous transfers submitted up to the one signaling a given notification value
+#define isTransferNotificationSignaled(x) ((int32_t)(*transfer_notification_addr - (x)) >= 0)
+
+// Macro to get the texture slot of a given texture name, its chunk must be allocated
+#define getTexture(id) (&texture_slots[(id) / TEXTURES_CHUNK_SIZE][(id) & (TEXTURES_CHUNK_SIZE - 1)])
+
+extern SceGxmTexture bound_frag_textures[TEXTURE_IMAGE_UNITS_NUM]; // Fragment textures last set on sceGxm context
+extern const void *bound_vertex_streams[VERTEX_ATTRIBS_NUM]; // Vertex streams last set on sceGxm context
 extern GLboolean use_vram; // Flag for VRAM usage for allocations
 
 // Macro to mark a pointer or a rendertarget as dirty for garbage collection
@@ -731,7 +777,7 @@ extern GLfloat pol_units; // Current units for glPolygonOffset
 
 // Texture Units
 extern texture_unit texture_units[COMBINED_TEXTURE_IMAGE_UNITS_NUM]; // Available texture units
-extern texture texture_slots[TEXTURES_NUM]; // Available texture slots
+extern texture *texture_slots[TEXTURES_NUM / TEXTURES_CHUNK_SIZE]; // Available texture slots, allocated in chunks on demand
 extern int8_t server_texture_unit; // Current in use server side texture unit
 extern int8_t client_texture_unit; // Current in use client side texture unit
 extern void *color_table; // Current in-use color table
@@ -820,6 +866,7 @@ extern GLuint cur_program; // Current in use custom program (0 = No custom progr
 extern uint32_t vsync_interval; // Current setting for VSync
 
 extern uint32_t vertex_array_unit; // Current in-use vertex array buffer unit
+extern uint32_t pixel_unpack_unit; // Current in-use pixel unpack buffer unit
 
 extern GLenum orig_depth_test; // Original depth test state (used for depth test invalidation)
 extern framebuffer *in_use_framebuffer; // Currently in use framebuffer
@@ -856,8 +903,43 @@ void startShaderPatcher(void); // Creates a shader patcher instance
 void stopShaderPatcher(void); // Destroys a shader patcher instance
 void waitRenderingDone(void); // Waits for rendering to be finished
 void sceneReset(void); // Resets drawing scene if required
+uint32_t getSceneNotificationValue(GLboolean *is_submitted); // Gets the notification value signaling completion of all the issued commands
+void invalidateContextBinds(void); // Forces next fragment textures and vertex streams binds to be sent to sceGxm context
+uint32_t getTransferNotification(SceGxmNotification *notification); // Sets up a notification to be signaled at the completion of an asynchronous transfer
+void waitTransferNotification(uint32_t value); // Waits for the GPU to signal a given transfer notification value
 GLboolean startShaderCompiler(void); // Starts a shader compiler instance
 
+// Waits for the completion of an asynchronous upload on a texture before accessing its data
+static inline void waitTextureUpload(texture *tex) {
+	if (tex->upload_fence) {
+		waitTransferNotification(tex->upload_fence);
+		tex->upload_fence = 0;
+	}
+}
+
+// Sets a fragment texture on sceGxm context only when it differs from the last set one
+static inline void setFragmentTexture(int i, texture *t) {
+	waitTextureUpload(t);
+	if (sceClibMemcmp(&bound_frag_textures[i], &t->gxm_tex, sizeof(SceGxmTexture))) {
+		sceClibMemcpy(&bound_frag_textures[i], &t->gxm_tex, sizeof(SceGxmTexture));
+		sceGxmSetFragmentTexture(gxm_context, i, &t->gxm_tex);
+	}
+}
+
+// Sets a vertex stream on sceGxm context only when it differs from the last set one
+static inline void setVertexStream(int i, const void *p) {
+	if (bound_vertex_streams[i] != p) {
+		bound_vertex_streams[i] = p;
+		sceGxmSetVertexStream(gxm_context, i, p);
+	}
+}
+
+/* queries.c */
+void bindVisibilityBuffer(void); // Binds the visibility buffer used for occlusion queries to the next scene
+void restoreVisibilityTest(void); // Sets visibility test state for the currently active occlusion query
+void stampSceneSubmission(uint32_t value); // Records submission time of the scene signaling a given notification value
+void stopTimerQueries(void); // Terminates the thread timestamping scenes completion
+
 /* tests.c */
 void change_depth_write(SceGxmDepthWriteMode mode); // Changes current in use depth write mode
 void change_depth_func(void); // Changes current in use depth test function
@@ -890,9 +972,24 @@ void _glDrawArrays_FixedFunctionIMPL(GLsizei count); // glDrawArrays implementat
 uint8_t reload_ffp_shaders(SceGxmVertexAttribute *attrs, SceGxmVertexStream *streams); // Reloads current in use ffp shaders
 void upload_ffp_uniforms(); // Uploads required uniforms for the in use ffp shaders
 void update_fogging_state(); // Updates current setup for fogging
+void shift_ffp_vertex_attribs(GLint num); // Moves the base of all ffp vertex attributes arrays by the given number of vertices
+
+/* draw.c */
+void purgeIndicesCache(gpubuffer *gpu_buf); // Invalidates converted and narrowed index lists cached for an element buffer
+void invalidateIndicesRange(gpubuffer *gpu_buf, int32_t offset, int32_t size); // Invalidates index lists cached for an element buffer after a write to a range of it
 
 /* vertex_buffers.c */
 void resetVao(vao *v); // Reseset vao state
+void *upload_client_array(const void *src, uint32_t size); // Gets a GPU copy of a client vertex array
+void resetClientArraysCacheBudget(void); // Resets per frame budget of client vertex arrays cache
+void purgeIdleBufferVersions(void); // Frees retired buffer versions that have not been recycled for a while
+
+/* textures.c */
+void processStagedUploads(void); // Uploads queued textures data within the per frame budget
+void completeStagedUpload(texture *tex); // Immediately uploads all the queued data of a texture
+void cancelStagedUpload(texture *tex); // Drops the queued data of a texture
+GLboolean allocTextureChunk(GLuint id); // Allocates the chunk of texture slots hosting a given texture name if missing, returns GL_FALSE on failure
+void releaseTextureName(GLuint id); // Makes a texture name available again for glGenTextures
 
 /* misc.c */
 void change_cull_mode(void); // Updates current cull mode
@@ -907,5 +1004,6 @@ void vgl_debugger_light_draw(uint32_t *fb); // Draws CPU rendered debugger windo
 
 /* vitaGL.c */
 uint8_t *reserve_data_pool(uint32_t size);
+uint32_t reserveDefaultIndices(uint32_t num); // Grows progressive indices buffers to address at least the given number of vertices, returns the number of addressable vertices
 
 #endif
@@ -0,0 +1,141 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * sync.c:
+ * Implementation for sync objects related functions
+ */
+
+#include "shared.h"
+
+#define FENCE_POLLING_DELAY 100 // Delay in microseconds between two fence status checks
+
+// Fence sync object struct
+typedef struct {
+	uint32_t value; // Scene notification value signaling the fence
+} fence;
+
+#define isFenceSignaled(x) isSceneNotificationSignaled(x->value)
+
+GLsync glFenceSync(GLenum condition, GLbitfield flags) {
+#ifndef SKIP_ERROR_HANDLING
+	if (condition != GL_SYNC_GPU_COMMANDS_COMPLETE) {
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_ENUM, 0, condition)
+	} else if (flags) {
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_VALUE, 0, flags)
+	}
+#endif
+
+	fence *f = (fence *)vglMalloc(sizeof(fence));
+#ifndef SKIP_ERROR_HANDLING
+	if (!f) {
+		SET_GL_ERROR_WITH_RET(GL_OUT_OF_MEMORY, 0)
+	}
+#endif
+	GLboolean is_submitted;
+	f->value = getSceneNotificationValue(&is_submitted);
+	return (GLsync)f;
+}
+
+GLboolean glIsSync(GLsync sync) {
+	return sync ? GL_TRUE : GL_FALSE;
+}
+
+void glDeleteSync(GLsync sync) {
+	if (sync)
+		vglFree((void *)sync);
+}
+
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+#ifndef SKIP_ERROR_HANDLING
+	if (!sync) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_VALUE, GL_WAIT_FAILED)
+	} else if (flags & ~GL_SYNC_FLUSH_COMMANDS_BIT) {
+		SET_GL_ERROR_WITH_RET_AND_VALUE(GL_INVALID_VALUE, GL_WAIT_FAILED, flags)
+	}
+#endif
+	fence *f = (fence *)sync;
+	if (isFenceSignaled(f))
+		return GL_ALREADY_SIGNALED;
+
+	// Submitting the scene signaling the fence if it's still being recorded, so that waiting on it can't hang
+	GLboolean is_submitted;
+	uint32_t pending_value = getSceneNotificationValue(&is_submitted);
+	if (!is_submitted && f->value == pending_value && ((flags & GL_SYNC_FLUSH_COMMANDS_BIT) || timeout))
+		glFlush();
+	if (!timeout)
+		return GL_TIMEOUT_EXPIRED;
+
+	// Polling the scene notification until the fence is signaled or the timeout (in nanoseconds) expires
+	SceUInt64 start = sceKernelGetProcessTimeWide();
+	while (!isFenceSignaled(f)) {
+		if (timeout != GL_TIMEOUT_IGNORED && (sceKernelGetProcessTimeWide() - start) * 1000 >= timeout)
+			return GL_TIMEOUT_EXPIRED;
+		sceKernelDelayThread(FENCE_POLLING_DELAY);
+	}
+	return GL_CONDITION_SATISFIED;
+}
+
+void glWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+#ifndef SKIP_ERROR_HANDLING
+	if (!sync) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	} else if (flags) {
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_VALUE, flags)
+	} else if (timeout != GL_TIMEOUT_IGNORED) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+#endif
+
+	// sceGxm executes scenes in submission order, so the GPU never needs to wait for an earlier fence
+}
+
+void glGetSynciv(GLsync sync, GLenum pname, GLsizei bufSize, GLsizei *length, GLint *values) {
+#ifndef SKIP_ERROR_HANDLING
+	if (!sync) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	} else if (bufSize < 0) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+#endif
+	if (!bufSize) {
+		if (length)
+			*length = 0;
+		return;
+	}
+
+	fence *f = (fence *)sync;
+	switch (pname) {
+	case GL_OBJECT_TYPE:
+		*values = GL_SYNC_FENCE;
+		break;
+	case GL_SYNC_STATUS:
+		*values = isFenceSignaled(f) ? GL_SIGNALED : GL_UNSIGNALED;
+		break;
+	case GL_SYNC_CONDITION:
+		*values = GL_SYNC_GPU_COMMANDS_COMPLETE;
+		break;
+	case GL_SYNC_FLAGS:
+		*values = 0;
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
+	}
+	if (length)
+		*length = 1;
+}
@@ -24,6 +24,9 @@
 #include "shared.h"
 #include "texture_callbacks.h"
 #include "vitaGL.h"
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
 
 #define convert_u16_to_u32_cspace(color, lshift, rshift, mask) ((((color << lshift) >> rshift) & mask) * 0xFF) / mask
 
@@ -201,3 +204,395 @@ void writeR(void *data, uint32_t color) {
 	uint8_t *src = (uint8_t *)&color;
 	dst[0] = src[0];
 }
+
+// Conversion kernel from 24bpp RGB to 32bpp RGBA format
+static void convertRGBtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 3, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	uint8x16_t alpha = vdupq_n_u8(0xFF);
+	while (count >= 16) {
+		uint8x16x3_t in = vld3q_u8(src);
+		uint8x16x4_t out = {{in.val[0], in.val[1], in.val[2], alpha}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		dst[3] = 0xFF;
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel from 24bpp BGR to 32bpp RGBA format
+static void convertBGRtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 3, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	uint8x16_t alpha = vdupq_n_u8(0xFF);
+	while (count >= 16) {
+		uint8x16x3_t in = vld3q_u8(src);
+		uint8x16x4_t out = {{in.val[2], in.val[1], in.val[0], alpha}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+		dst[3] = 0xFF;
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel swapping first and third channel of 24bpp formats (RGB <-> BGR)
+static void convertRGBtoBGR(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 3, dst_bpp = 3;
+#ifdef __ARM_NEON__
+	while (count >= 16) {
+		uint8x16x3_t in = vld3q_u8(src);
+		uint8x16x3_t out = {{in.val[2], in.val[1], in.val[0]}};
+		vst3q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel swapping first and third channel of 32bpp formats (RGBA <-> BGRA)
+static void convertBGRAtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 4, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	while (count >= 16) {
+		uint8x16x4_t in = vld4q_u8(src);
+		uint8x16x4_t out = {{in.val[2], in.val[1], in.val[0], in.val[3]}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+		dst[3] = src[3];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel from 32bpp ARGB to 32bpp RGBA format
+static void convertARGBtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 4, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	while (count >= 16) {
+		uint8x16x4_t in = vld4q_u8(src);
+		uint8x16x4_t out = {{in.val[1], in.val[2], in.val[3], in.val[0]}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[1];
+		dst[1] = src[2];
+		dst[2] = src[3];
+		dst[3] = src[0];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel reversing channels order of 32bpp formats (ABGR <-> RGBA)
+static void convertABGRtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 4, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	while (count >= 4) {
+		vst1q_u8(dst, vrev32q_u8(vld1q_u8(src)));
+		src += 4 * src_bpp;
+		dst += 4 * dst_bpp;
+		count -= 4;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[3];
+		dst[1] = src[2];
+		dst[2] = src[1];
+		dst[3] = src[0];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel from 32bpp RGBA to 24bpp RGB format
+static void convertRGBAtoRGB(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 4, dst_bpp = 3;
+#ifdef __ARM_NEON__
+	while (count >= 16) {
+		uint8x16x4_t in = vld4q_u8(src);
+		uint8x16x3_t out = {{in.val[0], in.val[1], in.val[2]}};
+		vst3q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel from 8bpp luminance to 32bpp RGBA format
+static void convertLtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 1, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	uint8x16_t alpha = vdupq_n_u8(0xFF);
+	while (count >= 16) {
+		uint8x16_t lum = vld1q_u8(src);
+		uint8x16x4_t out = {{lum, lum, lum, alpha}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = dst[1] = dst[2] = src[0];
+		dst[3] = 0xFF;
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+// Conversion kernel from 16bpp luminance alpha to 32bpp RGBA format
+static void convertLAtoRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+	const int src_bpp = 2, dst_bpp = 4;
+#ifdef __ARM_NEON__
+	while (count >= 16) {
+		uint8x16x2_t in = vld2q_u8(src);
+		uint8x16x4_t out = {{in.val[0], in.val[0], in.val[0], in.val[1]}};
+		vst4q_u8(dst, out);
+		src += 16 * src_bpp;
+		dst += 16 * dst_bpp;
+		count -= 16;
+	}
+#endif
+	while (count--) {
+		dst[0] = dst[1] = dst[2] = src[0];
+		dst[3] = src[1];
+		src += src_bpp;
+		dst += dst_bpp;
+	}
+}
+
+/*
+ * Lookup tables expanding 1, 4, 5 and 6 bits channels to 8 bits,
+ * matching the rounding of convert_u16_to_u32_cspace
+ */
+static uint8_t expand_lut_1bit[2];
+static uint8_t expand_lut_4bit[16];
+static uint8_t expand_lut_5bit[32];
+static uint8_t expand_lut_6bit[64];
+static GLboolean expand_luts_ready = GL_FALSE;
+
+static void init_expand_luts(void) {
+	for (int i = 0; i < 64; i++) {
+		if (i < 2)
+			expand_lut_1bit[i] = (i * 0xFF) / 0x01;
+		if (i < 16)
+			expand_lut_4bit[i] = (i * 0xFF) / 0x0F;
+		if (i < 32)
+			expand_lut_5bit[i] = (i * 0xFF) / 0x1F;
+		expand_lut_6bit[i] = (i * 0xFF) / 0x3F;
+	}
+	expand_luts_ready = GL_TRUE;
+}
+
+#ifdef __ARM_NEON__
+// Loads a 32 entries lookup table in NEON registers for vtbl4/vtbx4 lookups
+static inline uint8x8x4_t load_lut32(const uint8_t *lut) {
+	uint8x8x4_t t = {{vld1_u8(lut), vld1_u8(lut + 8), vld1_u8(lut + 16), vld1_u8(lut + 24)}};
+	return t;
+}
+#endif
+
+// Conversion kernel from 16bpp RGB565 to 32bpp RGBA format
+static void convertRGB565toRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+#ifdef __ARM_NEON__
+	uint8x8x4_t lut5 = load_lut32(expand_lut_5bit);
+	uint8x8x4_t lut6_lo = load_lut32(expand_lut_6bit);
+	uint8x8x4_t lut6_hi = load_lut32(expand_lut_6bit + 32);
+	while (count >= 8) {
+		uint16x8_t clr = vld1q_u16((const uint16_t *)src);
+		uint8x8_t g = vmovn_u16(vandq_u16(vshrq_n_u16(clr, 5), vdupq_n_u16(0x3F)));
+		uint8x8x4_t out;
+		out.val[0] = vtbl4_u8(lut5, vmovn_u16(vshrq_n_u16(clr, 11)));
+		// Indices past the first half of the table wrap below 32 for the second lookup only
+		out.val[1] = vtbx4_u8(vtbl4_u8(lut6_lo, g), lut6_hi, vsub_u8(g, vdup_n_u8(32)));
+		out.val[2] = vtbl4_u8(lut5, vand_u8(vmovn_u16(clr), vdup_n_u8(0x1F)));
+		out.val[3] = vdup_n_u8(0xFF);
+		vst4_u8(dst, out);
+		src += 8 * 2;
+		dst += 8 * 4;
+		count -= 8;
+	}
+#endif
+	while (count--) {
+		uint16_t clr = *(uint16_t *)src;
+		dst[0] = expand_lut_5bit[clr >> 11];
+		dst[1] = expand_lut_6bit[(clr >> 5) & 0x3F];
+		dst[2] = expand_lut_5bit[clr & 0x1F];
+		dst[3] = 0xFF;
+		src += 2;
+		dst += 4;
+	}
+}
+
+// Conversion kernel from 16bpp RGBA4444 to 32bpp RGBA format
+static void convertRGBA4444toRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+#ifdef __ARM_NEON__
+	uint8x8x2_t lut4 = {{vld1_u8(expand_lut_4bit), vld1_u8(expand_lut_4bit + 8)}};
+	uint8x8_t mask = vdup_n_u8(0x0F);
+	while (count >= 8) {
+		uint16x8_t clr = vld1q_u16((const uint16_t *)src);
+		uint8x8_t hi = vshrn_n_u16(clr, 8);
+		uint8x8_t lo = vmovn_u16(clr);
+		uint8x8x4_t out;
+		out.val[0] = vtbl2_u8(lut4, vshr_n_u8(hi, 4));
+		out.val[1] = vtbl2_u8(lut4, vand_u8(hi, mask));
+		out.val[2] = vtbl2_u8(lut4, vshr_n_u8(lo, 4));
+		out.val[3] = vtbl2_u8(lut4, vand_u8(lo, mask));
+		vst4_u8(dst, out);
+		src += 8 * 2;
+		dst += 8 * 4;
+		count -= 8;
+	}
+#endif
+	while (count--) {
+		uint16_t clr = *(uint16_t *)src;
+		dst[0] = expand_lut_4bit[clr >> 12];
+		dst[1] = expand_lut_4bit[(clr >> 8) & 0x0F];
+		dst[2] = expand_lut_4bit[(clr >> 4) & 0x0F];
+		dst[3] = expand_lut_4bit[clr & 0x0F];
+		src += 2;
+		dst += 4;
+	}
+}
+
+// Conversion kernel from 16bpp RGBA5551 to 32bpp RGBA format
+static void convertRGBA5551toRGBA(void *dst_data, const void *src_data, uint32_t count) {
+	const uint8_t *src = (const uint8_t *)src_data;
+	uint8_t *dst = (uint8_t *)dst_data;
+#ifdef __ARM_NEON__
+	uint8x8x4_t lut5 = load_lut32(expand_lut_5bit);
+	uint8x8_t mask = vdup_n_u8(0x1F);
+	while (count >= 8) {
+		uint16x8_t clr = vld1q_u16((const uint16_t *)src);
+		uint8x8x4_t out;
+		out.val[0] = vtbl4_u8(lut5, vmovn_u16(vshrq_n_u16(clr, 11)));
+		out.val[1] = vtbl4_u8(lut5, vand_u8(vmovn_u16(vshrq_n_u16(clr, 6)), mask));
+		out.val[2] = vtbl4_u8(lut5, vand_u8(vmovn_u16(vshrq_n_u16(clr, 1)), mask));
+		// Subtracting the alpha bit from zero gives the same 0x00/0xFF values as expand_lut_1bit
+		out.val[3] = vsub_u8(vdup_n_u8(0), vand_u8(vmovn_u16(clr), vdup_n_u8(0x01)));
+		vst4_u8(dst, out);
+		src += 8 * 2;
+		dst += 8 * 4;
+		count -= 8;
+	}
+#endif
+	while (count--) {
+		uint16_t clr = *(uint16_t *)src;
+		dst[0] = expand_lut_5bit[clr >> 11];
+		dst[1] = expand_lut_5bit[(clr >> 6) & 0x1F];
+		dst[2] = expand_lut_5bit[(clr >> 1) & 0x1F];
+		dst[3] = expand_lut_1bit[clr & 0x01];
+		src += 2;
+		dst += 4;
+	}
+}
+
+convert_cb getConvertCallback(uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t)) {
+	if (write_cb == writeRGBA) {
+		if (read_cb == readRGB)
+			return convertRGBtoRGBA;
+		if (read_cb == readBGR)
+			return convertBGRtoRGBA;
+		if (read_cb == readBGRA)
+			return convertBGRAtoRGBA;
+		if (read_cb == readARGB)
+			return convertARGBtoRGBA;
+		if (read_cb == readABGR)
+			return convertABGRtoRGBA;
+		if (read_cb == readL)
+			return convertLtoRGBA;
+		if (read_cb == readLA)
+			return convertLAtoRGBA;
+		if (!expand_luts_ready)
+			init_expand_luts();
+		if (read_cb == readRGB565)
+			return convertRGB565toRGBA;
+		if (read_cb == readRGBA4444)
+			return convertRGBA4444toRGBA;
+		if (read_cb == readRGBA5551)
+			return convertRGBA5551toRGBA;
+	} else if (write_cb == writeBGRA) {
+		if (read_cb == readRGBA)
+			return convertBGRAtoRGBA;
+	} else if (write_cb == writeABGR) {
+		if (read_cb == readRGBA)
+			return convertABGRtoRGBA;
+	} else if (write_cb == writeRGB) {
+		if (read_cb == readRGBA)
+			return convertRGBAtoRGB;
+		if (read_cb == readBGR)
+			return convertRGBtoBGR;
+	} else if (write_cb == writeBGR) {
+		if (read_cb == readRGB)
+			return convertRGBtoBGR;
+	}
+	return NULL;
+}
@@ -50,4 +50,8 @@ void writeRGBA(void *data, uint32_t color);
 void writeABGR(void *data, uint32_t color);
 void writeBGRA(void *data, uint32_t color);
 
+// Conversion kernels for whole lines of pixels
+typedef void (*convert_cb)(void *dst, const void *src, uint32_t count);
+convert_cb getConvertCallback(uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t)); // Returns a conversion kernel for a read/write callbacks pair, NULL if none is available
+
 #endif
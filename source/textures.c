@@ -24,12 +24,202 @@
 #include "shared.h"
 
 texture_unit texture_units[COMBINED_TEXTURE_IMAGE_UNITS_NUM]; // Available texture units
-texture texture_slots[TEXTURES_NUM]; // Available texture slots
+texture *texture_slots[TEXTURES_NUM / TEXTURES_CHUNK_SIZE]; // Available texture slots, allocated in chunks on demand
+static uint32_t texture_names_mask[TEXTURES_NUM / 32]; // Bitmask of the texture names available for glGenTextures
+static uint32_t texture_names_hint = 0; // Lowest texture_names_mask word that may hold available names
 
 void *color_table = NULL; // Current in-use color table
 int8_t server_texture_unit = 0; // Current in use server side texture unit
 int unpack_row_len = 0; // Current setting for GL_UNPACK_ROW_LENGTH
 
+#define STAGED_UPLOAD_LINES_CHUNK 16 // Maximum number of lines uploaded between two budget checks (Must be a multiple of 4)
+
+typedef void (*decode_cb)(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h);
+
+typedef struct staged_upload {
+	texture *tex; // Texture the upload is targeting
+	uint8_t *data; // Staging copy of the source pixels
+	uint32_t w; // Width in pixels of the upload
+	uint32_t h; // Height in pixels of the upload
+	uint32_t line; // Next line to be uploaded
+	uint32_t line_size; // Size in bytes of an uploaded texture line
+	uint8_t src_bpp; // Bytes per pixel of the source pixels
+	uint32_t (*read_cb)(void *); // Read callback for the source pixels
+	GLboolean fast_store; // Whether source pixels can be copied as is
+	decode_cb decode; // Block decoder for compressed source data (NULL for uncompressed source data)
+	uint32_t block_row_size; // Size in bytes of a row of compressed blocks
+	uint8_t *decoded; // Scratch buffer holding decoded source lines
+	struct staged_upload *next; // Next queued upload
+} staged_upload;
+
+static staged_upload *staged_uploads_head = NULL; // First queued texture upload
+static staged_upload *staged_uploads_tail = NULL; // Last queued texture upload
+static uint32_t staged_uploads_bytes_budget = 0; // Maximum amount of bytes uploaded per frame by the uploads queue (0 = Unlimited)
+static uint32_t staged_uploads_time_budget = 0; // Maximum time in microseconds spent per frame on the uploads queue (0 = Unlimited)
+
+static void upload_staged_lines(staged_upload *u, uint32_t lines) {
+	texture *tex = u->tex;
+	uint8_t bpp = tex_format_to_bytespp(sceGxmTextureGetFormat(&tex->gxm_tex));
+	uint32_t stride = ALIGN(u->w, 8) * bpp;
+	if (u->decode) {
+		// Decoding compressed blocks in bands of lines, uploads always start on a block row
+		while (lines) {
+			uint32_t band = lines > STAGED_UPLOAD_LINES_CHUNK ? STAGED_UPLOAD_LINES_CHUNK : lines;
+			u->decode(u->data + (u->line / 4) * u->block_row_size, u->decoded, u->w, band);
+			gpu_store_texture_lines((uint8_t *)tex->data + stride * u->line, stride, u->decoded, u->w, band, bpp, u->src_bpp, u->read_cb, tex->write_cb, u->fast_store);
+			u->line += band;
+			lines -= band;
+		}
+	} else {
+		gpu_store_texture_lines((uint8_t *)tex->data + stride * u->line, stride, u->data + u->w * u->src_bpp * u->line, u->w, lines, bpp, u->src_bpp, u->read_cb, tex->write_cb, u->fast_store);
+		u->line += lines;
+	}
+}
+
+static void release_staged_upload(staged_upload *u) {
+	// Unlinking the upload from the queue
+	staged_upload *prev = NULL;
+	staged_upload *cur = staged_uploads_head;
+	while (cur != u) {
+		prev = cur;
+		cur = cur->next;
+	}
+	if (prev)
+		prev->next = u->next;
+	else
+		staged_uploads_head = u->next;
+	if (staged_uploads_tail == u)
+		staged_uploads_tail = prev;
+
+	u->tex->staged_upload = NULL;
+	if (u->decoded)
+		vglFree(u->decoded);
+	vglFree(u->data);
+	vglFree(u);
+}
+
+static staged_upload *stage_texture_upload(texture *tex, const void *data, uint32_t size, uint32_t w, uint32_t h, uint8_t src_bpp, uint32_t (*read_cb)(void *), GLboolean fast_store) {
+	// Staging a copy of the source data since the application is free to release it once we return
+	staged_upload *u = (staged_upload *)vglMalloc(sizeof(staged_upload));
+	if (!u)
+		return NULL;
+	u->data = (uint8_t *)vglMalloc(size);
+	if (!u->data) {
+		vglFree(u);
+		return NULL;
+	}
+	vgl_fast_memcpy(u->data, data, size);
+
+	u->tex = tex;
+	u->w = w;
+	u->h = h;
+	u->line = 0;
+	u->line_size = w * tex_format_to_bytespp(sceGxmTextureGetFormat(&tex->gxm_tex));
+	u->src_bpp = src_bpp;
+	u->read_cb = read_cb;
+	u->fast_store = fast_store;
+	u->decode = NULL;
+	u->block_row_size = 0;
+	u->decoded = NULL;
+	u->next = NULL;
+	return u;
+}
+
+static void enqueue_staged_upload(staged_upload *u) {
+	if (staged_uploads_tail)
+		staged_uploads_tail->next = u;
+	else
+		staged_uploads_head = u;
+	staged_uploads_tail = u;
+	u->tex->staged_upload = u;
+}
+
+static void queue_texture_upload(texture *tex, const void *data, uint32_t w, uint32_t h, uint8_t src_bpp, uint32_t (*read_cb)(void *), GLboolean fast_store) {
+	// Texture storage allocation failed, nothing to upload
+	if (tex->status != TEX_VALID)
+		return;
+
+	staged_upload *u = stage_texture_upload(tex, data, w * h * src_bpp, w, h, src_bpp, read_cb, fast_store);
+	if (!u) {
+		// Not enough memory for staging, uploading pixels immediately
+		uint8_t bpp = tex_format_to_bytespp(sceGxmTextureGetFormat(&tex->gxm_tex));
+		gpu_store_texture_lines(tex->data, ALIGN(w, 8) * bpp, data, w, h, bpp, src_bpp, read_cb, tex->write_cb, fast_store);
+		return;
+	}
+	enqueue_staged_upload(u);
+}
+
+static GLboolean queue_compressed_texture_upload(texture *tex, const void *data, uint32_t size, uint32_t w, uint32_t h, uint8_t src_bpp, decode_cb decode, uint32_t block_row_size) {
+	// Texture storage allocation failed, nothing to upload
+	if (tex->status != TEX_VALID)
+		return GL_TRUE;
+
+	// Decoded blocks are already in the texture format, so they can be copied as is
+	staged_upload *u = stage_texture_upload(tex, data, size, w, h, src_bpp, NULL, GL_TRUE);
+	if (!u)
+		return GL_FALSE;
+	u->decoded = (uint8_t *)vglMalloc(w * STAGED_UPLOAD_LINES_CHUNK * src_bpp);
+	if (!u->decoded) {
+		vglFree(u->data);
+		vglFree(u);
+		return GL_FALSE;
+	}
+	u->decode = decode;
+	u->block_row_size = block_row_size;
+	enqueue_staged_upload(u);
+	return GL_TRUE;
+}
+
+void completeStagedUpload(texture *tex) {
+	staged_upload *u = (staged_upload *)tex->staged_upload;
+	upload_staged_lines(u, u->h - u->line);
+	release_staged_upload(u);
+}
+
+void cancelStagedUpload(texture *tex) {
+	release_staged_upload((staged_upload *)tex->staged_upload);
+}
+
+void processStagedUploads(void) {
+	SceUInt64 start = sceKernelGetProcessTimeWide();
+	uint32_t bytes = 0;
+	while (staged_uploads_head) {
+		staged_upload *u = staged_uploads_head;
+		uint32_t lines = u->h - u->line;
+		if (lines > STAGED_UPLOAD_LINES_CHUNK)
+			lines = STAGED_UPLOAD_LINES_CHUNK;
+
+		// Clamping uploaded lines to the remaining bytes budget, at least one line is uploaded per frame so that the queue always progresses
+		if (staged_uploads_bytes_budget) {
+			if (bytes >= staged_uploads_bytes_budget)
+				break;
+			uint32_t budget_lines = (staged_uploads_bytes_budget - bytes) / u->line_size;
+			if (!budget_lines) {
+				if (bytes)
+					break;
+				budget_lines = 1;
+			}
+			if (lines > budget_lines)
+				lines = budget_lines;
+		}
+
+		// Compressed uploads always progress by whole block rows
+		if (u->decode) {
+			lines = ALIGN(lines, 4);
+			if (lines > u->h - u->line)
+				lines = u->h - u->line;
+		}
+
+		upload_staged_lines(u, lines);
+		bytes += lines * u->line_size;
+		if (u->line == u->h)
+			release_staged_upload(u);
+
+		if (staged_uploads_time_budget && sceKernelGetProcessTimeWide() - start >= staged_uploads_time_budget)
+			break;
+	}
+}
+
 void _glTexImage2D_CubeIMPL(texture *tex, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data, int index) {
 	SceGxmTextureFormat tex_format;
 	SceGxmTransferFormat src_format;
@@ -404,9 +594,14 @@ void _glTexImage2D_FlatIMPL(texture *tex, GLint level, GLint internalFormat, GLs
 	// Allocating texture/mipmaps depending on user call
 	tex->type = internalFormat;
 	if (level == 0)
-		if (tex->write_cb)
-			gpu_alloc_texture(width, height, tex_format, data, tex, data_bpp, read_cb, tex->write_cb, fast_store);
-		else
+		if (tex->write_cb) {
+			if (data && !fast_store && !pixel_unpack_unit && (staged_uploads_bytes_budget || staged_uploads_time_budget)) {
+				// Texture needs per pixel conversion, so it gets a blank storage usable right away, filled by the uploads queue over the next frames
+				gpu_alloc_texture(width, height, tex_format, NULL, tex, data_bpp, read_cb, tex->write_cb, fast_store, GL_FALSE);
+				queue_texture_upload(tex, data, width, height, data_bpp, read_cb, fast_store);
+			} else
+				gpu_alloc_texture(width, height, tex_format, data, tex, data_bpp, read_cb, tex->write_cb, fast_store, pixel_unpack_unit != 0);
+		} else
 			gpu_alloc_compressed_texture(level, width, height, tex_format, 0, data, tex, data_bpp, read_cb);
 	else if (tex->write_cb)
 		gpu_alloc_mipmaps(level, tex);
@@ -455,34 +650,86 @@ void glGenTextures(GLsizei n, GLuint *res) {
 	}
 #endif
 
-	// Reserving a texture and returning its id if available
+	// Reserving the lowest available texture names, allocating new slots once they run out
 	int j = 0;
-	for (GLuint i = 1; i < TEXTURES_NUM; i++) {
-		if (texture_slots[i].status == TEX_UNUSED) {
-			res[j++] = i;
-			texture_slots[i].status = TEX_UNINITIALIZED;
-
-			// Resetting texture parameters to their default values
-			texture_slots[i].dirty = GL_FALSE;
-			texture_slots[i].faces_counter = 0;
-			texture_slots[i].ref_counter = 0;
-			texture_slots[i].mip_count = 1;
+	while (j < n) {
+		while (texture_names_hint < TEXTURES_NUM / 32 && !texture_names_mask[texture_names_hint])
+			texture_names_hint++;
+		if (texture_names_hint == TEXTURES_NUM / 32) {
+			GLuint chunk = 0;
+			while (chunk < TEXTURES_NUM / TEXTURES_CHUNK_SIZE && texture_slots[chunk])
+				chunk++;
+			if (chunk == TEXTURES_NUM / TEXTURES_CHUNK_SIZE) {
+				vgl_log("%s:%d glGenTextures: Texture slots limit reached (%d textures hadn't been generated).\n", __FILE__, __LINE__, n - j);
+				return;
+			}
+			if (!allocTextureChunk(chunk * TEXTURES_CHUNK_SIZE)) {
+				SET_GL_ERROR(GL_OUT_OF_MEMORY)
+			}
+			continue;
+		}
+		uint32_t bit = __builtin_ctz(texture_names_mask[texture_names_hint]);
+		texture_names_mask[texture_names_hint] &= ~(1u << bit);
+		GLuint i = texture_names_hint * 32 + bit;
+		texture *tex = getTexture(i);
+
+		// Names bound without being generated may be already in use
+		if (tex->status != TEX_UNUSED)
+			continue;
+		res[j++] = i;
+		tex->status = TEX_UNINITIALIZED;
+
+		// Resetting texture parameters to their default values
+		tex->dirty = GL_FALSE;
+		tex->upload_fence = 0;
+		tex->staged_upload = NULL;
+		tex->mip_streaming = GL_FALSE;
+		tex->stream_levels = 0;
+		tex->stream_lod_min = 0;
+		tex->is_transcoded = GL_FALSE;
+		tex->faces_counter = 0;
+		tex->ref_counter = 0;
+		tex->mip_count = 1;
 #ifdef HAVE_UNPURE_TEXTURES
-			texture_slots[i].mip_start = -1;
+		tex->mip_start = -1;
 #endif
-			texture_slots[i].use_mips = GL_FALSE;
-			texture_slots[i].min_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
-			texture_slots[i].mag_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
-			texture_slots[i].mip_filter = SCE_GXM_TEXTURE_MIP_FILTER_DISABLED;
-			texture_slots[i].u_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
-			texture_slots[i].v_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
-			texture_slots[i].lod_bias = GL_MAX_TEXTURE_LOD_BIAS; // sceGxm range is 0 - (GL_MAX_TEXTURE_LOD_BIAS*2 + 1)
+		tex->use_mips = GL_FALSE;
+		tex->min_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
+		tex->mag_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
+		tex->mip_filter = SCE_GXM_TEXTURE_MIP_FILTER_DISABLED;
+		tex->u_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
+		tex->v_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
+		tex->lod_bias = GL_MAX_TEXTURE_LOD_BIAS; // sceGxm range is 0 - (GL_MAX_TEXTURE_LOD_BIAS*2 + 1)
+	}
+}
+
+GLboolean allocTextureChunk(GLuint id) {
+	const GLuint chunk = id / TEXTURES_CHUNK_SIZE;
+	if (texture_slots[chunk])
+		return GL_TRUE;
+
+	// New slots sample the default texture until they get some data
+	texture *slots = (texture *)vglMalloc(TEXTURES_CHUNK_SIZE * sizeof(texture));
+	if (!slots)
+		return GL_FALSE;
+	sceClibMemset(slots, 0, TEXTURES_CHUNK_SIZE * sizeof(texture));
+	texture_slots[chunk] = slots;
+	for (GLuint i = 0; i < TEXTURES_CHUNK_SIZE; i++) {
+		slots[i].id = chunk * TEXTURES_CHUNK_SIZE + i;
+		slots[i].status = TEX_UNUSED;
+		if (slots[i].id) {
+			if (texture_slots[0] != slots)
+				slots[i].gxm_tex = texture_slots[0][0].gxm_tex;
+			releaseTextureName(slots[i].id);
 		}
-		if (j >= n)
-			return;
 	}
+	return GL_TRUE;
+}
 
-	vgl_log("%s:%d glGenTextures: Texture slots limit reached (%d textures hadn't been generated).\n", __FILE__, __LINE__, n - j);
+void releaseTextureName(GLuint id) {
+	texture_names_mask[id / 32] |= 1u << (id % 32);
+	if (id / 32 < texture_names_hint)
+		texture_names_hint = id / 32;
 }
 
 void glBindTexture(GLenum target, GLuint texture) {
@@ -491,7 +738,16 @@ void glBindTexture(GLenum target, GLuint texture) {
 	if (_vgl_enqueue_list_func(glBindTexture, "UU", target, texture))
 		return;
 #endif
-	// Setting current in use texture id for the in use server texture unit
+#ifndef SKIP_ERROR_HANDLING
+	if (texture >= TEXTURES_NUM) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+#endif
+
+	// Setting current in use texture id for the in use server texture unit, names bound without being generated get their slot here
+	if (!allocTextureChunk(texture)) {
+		SET_GL_ERROR(GL_OUT_OF_MEMORY)
+	}
 	texture_units[server_texture_unit].tex_id = texture;
 }
 
@@ -506,17 +762,21 @@ void glDeleteTextures(GLsizei n, const GLuint *gl_textures) {
 	// Deallocating given textures and invalidating used texture ids
 	for (int j = 0; j < n; j++) {
 		GLuint i = gl_textures[j];
-		if (i > 0) {
-			if (texture_slots[i].status == TEX_VALID) {
-				if (texture_slots[i].ref_counter > 0)
-					if (texture_slots[i].ref_counter == 1) {
+		if (i > 0 && i < TEXTURES_NUM && texture_slots[i / TEXTURES_CHUNK_SIZE]) {
+			texture *tex = getTexture(i);
+			if (tex->status == TEX_UNINITIALIZED) {
+				tex->status = TEX_UNUSED;
+				releaseTextureName(i);
+			} else if (tex->status == TEX_VALID) {
+				if (tex->ref_counter > 0)
+					if (tex->ref_counter == 1) {
 						framebuffer *fb = NULL;
-						if (active_read_fb && active_read_fb->tex == &texture_slots[i])
+						if (active_read_fb && active_read_fb->tex == tex)
 							fb = active_read_fb;
-						else if (active_write_fb && active_write_fb->tex == &texture_slots[i])
+						else if (active_write_fb && active_write_fb->tex == tex)
 							fb = active_write_fb;
 						if (fb) {
-							gpu_free_texture(&texture_slots[i]);
+							gpu_free_texture(tex);
 							if (fb->depthbuffer_ptr && fb->is_depth_hidden) {
 								markAsDirty(fb->depthbuffer_ptr->depthData);
 								fb->depthbuffer_ptr = NULL;
@@ -528,12 +788,12 @@ void glDeleteTextures(GLsizei n, const GLuint *gl_textures) {
 							}
 							fb->tex = NULL;
 						} else
-							texture_slots[i].dirty = GL_TRUE;
+							tex->dirty = GL_TRUE;
 					} else {
-						texture_slots[i].dirty = GL_TRUE;
+						tex->dirty = GL_TRUE;
 					}
 				else
-					gpu_free_texture(&texture_slots[i]);
+					gpu_free_texture(tex);
 			}
 
 			for (int k = 0; k < TEXTURE_IMAGE_UNITS_NUM; k++) {
@@ -549,7 +809,7 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 #ifndef SKIP_ERROR_HANDLING
 	// Checking if texture is too big for sceGxm
@@ -580,6 +840,13 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei widt
 		break;
 	}
 
+	// When a pixel unpack buffer is bound, data is an offset in its storage
+	if (pixel_unpack_unit) {
+		gpubuffer *unpack_buf = (gpubuffer *)pixel_unpack_unit;
+		markBufferAsUsed(unpack_buf)
+		data = (uint8_t *)unpack_buf->ptr + (uint32_t)data;
+	}
+
 	switch (target) {
 	case GL_TEXTURE_2D:
 		_glTexImage2D_FlatIMPL(tex, level, internalFormat, width, height, format, type, data);
@@ -601,7 +868,7 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, G
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *target_texture = &texture_slots[texture2d_idx];
+	texture *target_texture = getTexture(texture2d_idx);
 
 #ifdef HAVE_UNPURE_TEXTURES
 	level -= target_texture->mip_start;
@@ -643,6 +910,13 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, G
 		break;
 	}
 
+	// When a pixel unpack buffer is bound, pixels is an offset in its storage
+	if (pixel_unpack_unit) {
+		gpubuffer *unpack_buf = (gpubuffer *)pixel_unpack_unit;
+		markBufferAsUsed(unpack_buf)
+		pixels = (uint8_t *)unpack_buf->ptr + (uint32_t)pixels;
+	}
+
 	/*
 	 * Callbacks are actually used to just perform down/up-sampling
 	 * between U8 texture formats. Reads are expected to give as result
@@ -803,6 +1077,17 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, G
 			break;
 		}
 
+		// Flushing any staged upload so that it can't overwrite the new data later on
+		if (target_texture->staged_upload)
+			completeStagedUpload(target_texture);
+
+		// Pixel unpack buffers are sceGxm mapped, so plain copies can be queued on the transfer engine
+		if (fast_store && pixel_unpack_unit && gpu_transfer_texture_data(target_texture, tex_format, xoffset, yoffset, width, height, pixels, unpack_row_len ? (unpack_row_len * bpp) : width * data_bpp))
+			break;
+
+		// Waiting for any pending asynchronous upload before writing texture data with the CPU
+		waitTextureUpload(target_texture);
+
 		if (fast_store) { // Internal format and input format are the same, we can take advantage of this
 			uint8_t *data = (uint8_t *)pixels;
 			uint32_t line_size = width * data_bpp;
@@ -811,14 +1096,20 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, G
 				data += unpack_row_len ? (unpack_row_len * bpp) : line_size;
 				ptr += stride;
 			}
-		} else { // Executing texture modification via callbacks
+		} else { // Executing texture modification via conversion kernels or callbacks
+			convert_cb convert = getConvertCallback(read_cb, write_cb);
 			uint8_t *data = (uint8_t *)pixels;
 			for (i = 0; i < height; i++) {
-				for (j = 0; j < width; j++) {
-					uint32_t clr = read_cb((uint8_t *)data);
-					write_cb(ptr, clr);
-					data += data_bpp;
-					ptr += bpp;
+				if (convert) {
+					convert(ptr, data, width);
+					data += width * data_bpp;
+				} else {
+					for (j = 0; j < width; j++) {
+						uint32_t clr = read_cb((uint8_t *)data);
+						write_cb(ptr, clr);
+						data += data_bpp;
+						ptr += bpp;
+					}
 				}
 				if (unpack_row_len) {
 					data = pixels + unpack_row_len * bpp;
@@ -835,11 +1126,33 @@ void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, G
 	}
 }
 
+#ifdef DISABLE_HW_ETC1
+static void decode_etc1(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h) {
+	etc1_decode_image((etc1_byte *)src, (etc1_byte *)dst, w, h, 3, w * 3);
+}
+#endif
+
+static void decode_etc2_eac(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h) {
+	eac_decode((uint8_t *)src, dst, w, h, EAC_ETC2);
+}
+
+static void decode_atc_rgb(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h) {
+	atitc_decode((uint8_t *)src, dst, w, h, ATC_RGB);
+}
+
+static void decode_atc_explicit_alpha(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h) {
+	atitc_decode((uint8_t *)src, dst, w, h, ATC_EXPLICIT_ALPHA);
+}
+
+static void decode_atc_interpolated_alpha(const uint8_t *src, uint8_t *dst, uint32_t w, uint32_t h) {
+	atitc_decode((uint8_t *)src, dst, w, h, ATC_INTERPOLATED_ALPHA);
+}
+
 void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) {
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 #ifdef HAVE_UNPURE_TEXTURES
 	if (tex->mip_start < 0)
@@ -851,7 +1164,12 @@ void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, G
 	GLboolean gamma_correction = GL_FALSE;
 	GLboolean non_native_format = GL_FALSE;
 	GLboolean paletted_format = GL_FALSE;
-	void *decompressed_data;
+	GLboolean transcoded_format = GL_FALSE;
+	transcode_mode transcode;
+	void *transcoded_data;
+	decode_cb decode = NULL;
+	uint32_t block_row_size = 0;
+	uint64_t cache_key = 0;
 	uint8_t data_bpp;
 	uint32_t (*read_cb)(void *) = NULL;
 
@@ -867,6 +1185,13 @@ void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, G
 	}
 #endif
 
+	// When a pixel unpack buffer is bound, data is an offset in its storage
+	if (pixel_unpack_unit) {
+		gpubuffer *unpack_buf = (gpubuffer *)pixel_unpack_unit;
+		markBufferAsUsed(unpack_buf)
+		data = (uint8_t *)unpack_buf->ptr + (uint32_t)data;
+	}
+
 	switch (target) {
 	case GL_TEXTURE_2D:
 		// Detecting proper write callback and texture format
@@ -968,67 +1293,82 @@ void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, G
 #ifndef DISABLE_HW_ETC1
 			tex_format = SCE_GXM_TEXTURE_FORMAT_ETC1_RGB;
 #else
-			non_native_format = GL_TRUE;
-			decompressed_data = vglMalloc(width * height * 3);
-			etc1_decode_image((etc1_byte *)data, (etc1_byte *)decompressed_data, width, height, 3, width * 3);
 			if (recompress_non_native) {
-				read_cb = readRGB;
+				transcoded_format = GL_TRUE;
+				transcode = TRANSCODE_ETC1_TO_DXT1;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR;
-			} else
+			} else {
+				non_native_format = GL_TRUE;
+				decode = decode_etc1;
+				block_row_size = ((width + 3) / 4) * 8;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8_BGR;
-			data_bpp = 3;
+				data_bpp = 3;
+			}
 #endif
 			break;
 		case GL_COMPRESSED_RGBA8_ETC2_EAC:
-			non_native_format = GL_TRUE;
-			decompressed_data = vglMalloc(width * height * 4);
-			eac_decode((uint8_t *)data, decompressed_data, width, height, EAC_ETC2);
 			if (recompress_non_native) {
-				read_cb = readRGBA;
+				transcoded_format = GL_TRUE;
+				transcode = TRANSCODE_ETC2_EAC_TO_DXT5;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR;
-			} else
+			} else {
+				non_native_format = GL_TRUE;
+				decode = decode_etc2_eac;
+				block_row_size = (width / 4) * 16;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ABGR;
-			data_bpp = 4;
+				data_bpp = 4;
+			}
 			break;
 		case GL_ATC_RGB_AMD:
-			non_native_format = GL_TRUE;
-			decompressed_data = vglMalloc(width * height * 4);
-			atitc_decode((uint8_t *)data, decompressed_data, width, height, ATC_RGB);
 			if (recompress_non_native) {
-				read_cb = readBGRA;
+				transcoded_format = GL_TRUE;
+				transcode = TRANSCODE_ATC_RGB_TO_DXT1;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR;
-			} else
+			} else {
+				non_native_format = GL_TRUE;
+				decode = decode_atc_rgb;
+				block_row_size = (width / 4) * 8;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB;
-			data_bpp = 4;
+				data_bpp = 4;
+			}
 			break;
 		case GL_ATC_RGBA_EXPLICIT_ALPHA_AMD:
-			non_native_format = GL_TRUE;
-			decompressed_data = vglMalloc(width * height * 4);
-			atitc_decode((uint8_t *)data, decompressed_data, width, height, ATC_EXPLICIT_ALPHA);
 			if (recompress_non_native) {
-				read_cb = readBGRA;
-				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR;
-			} else
+				transcoded_format = GL_TRUE;
+				transcode = TRANSCODE_ATC_EXPLICIT_ALPHA_TO_DXT3;
+				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR;
+			} else {
+				non_native_format = GL_TRUE;
+				decode = decode_atc_explicit_alpha;
+				block_row_size = (width / 4) * 16;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB;
-			data_bpp = 4;
+				data_bpp = 4;
+			}
 			break;
 		case GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD:
-			non_native_format = GL_TRUE;
-			decompressed_data = vglMalloc(width * height * 4);
-			atitc_decode((uint8_t *)data, decompressed_data, width, height, ATC_INTERPOLATED_ALPHA);
 			if (recompress_non_native) {
-				read_cb = readBGRA;
+				transcoded_format = GL_TRUE;
+				transcode = TRANSCODE_ATC_INTERPOLATED_ALPHA_TO_DXT5;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR;
-			} else
+			} else {
+				non_native_format = GL_TRUE;
+				decode = decode_atc_interpolated_alpha;
+				block_row_size = (width / 4) * 16;
 				tex_format = SCE_GXM_TEXTURE_FORMAT_U8U8U8U8_ARGB;
-			data_bpp = 4;
+				data_bpp = 4;
+			}
 			break;
 		default:
 			SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, internalFormat)
 		}
 
+		// Converted non native formats are fetched from and saved to the persistent cache when enabled
+		if ((transcoded_format || non_native_format) && vgl_cache_enabled())
+			cache_key = vgl_cache_hash(data, imageSize, ((uint64_t)internalFormat << 32) ^ ((uint64_t)width << 16) ^ height ^ ((uint64_t)transcoded_format << 63));
+
 		// Allocating texture/mipmaps depending on user call
 		tex->type = internalFormat;
+		tex->is_transcoded = transcoded_format;
 		if (paletted_format) {
 #ifndef SKIP_ERROR_HANDLING
 			if (level > 0) {
@@ -1044,18 +1384,63 @@ void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, G
 			}
 #endif
 			if (non_native_format) {
-				if (level == 0)
-					if (read_cb)
-						gpu_alloc_compressed_texture(level, width, height, tex_format, 0, decompressed_data, tex, data_bpp, read_cb);
+				// Decoding is not staged when going through the persistent cache since it needs the whole payload at once
+				GLboolean staged = GL_FALSE;
+				if (level == 0 && !cache_key && (staged_uploads_bytes_budget || staged_uploads_time_budget)) {
+					// Texture gets a blank storage usable right away, blocks are decoded by the uploads queue over the next frames
+					gpu_alloc_texture(width, height, tex_format, NULL, tex, data_bpp, NULL, NULL, GL_TRUE, GL_FALSE);
+					staged = queue_compressed_texture_upload(tex, data, imageSize, width, height, data_bpp, decode, block_row_size);
+				}
+				if (!staged) {
+					void *decompressed_data = vglMalloc(width * height * data_bpp);
+					if (!decompressed_data) {
+						SET_GL_ERROR(GL_OUT_OF_MEMORY)
+					}
+					if (!cache_key || !vgl_cache_load(cache_key, decompressed_data, width * height * data_bpp, imageSize, internalFormat, width, height)) {
+						decode(data, decompressed_data, width, height);
+						if (cache_key)
+							vgl_cache_store(cache_key, decompressed_data, width * height * data_bpp, imageSize, internalFormat, width, height);
+					}
+					if (level == 0)
+						gpu_alloc_texture(width, height, tex_format, decompressed_data, tex, data_bpp, NULL, NULL, GL_TRUE, GL_FALSE);
 					else
-						gpu_alloc_texture(width, height, tex_format, decompressed_data, tex, data_bpp, NULL, NULL, GL_TRUE);
-				else if (read_cb)
-					gpu_alloc_compressed_texture(level, width, height, tex_format, 0, decompressed_data, tex, data_bpp, read_cb);
+						gpu_alloc_mipmaps(level, tex);
+					vgl_free(decompressed_data);
+				}
+			} else {
+#ifndef SKIP_ERROR_HANDLING
+				// Uploaded level must match its slot in the mipchain declared with vglTexMipStreaming
+				if (tex->mip_streaming && (!((tex->stream_width >> level) | (tex->stream_height >> level)) || width != MAX(tex->stream_width >> level, 1) || height != MAX(tex->stream_height >> level, 1))) {
+					SET_GL_ERROR(GL_INVALID_VALUE)
+				}
+#endif
+				// Transcoded blocks have the same size of the source ones and are uploaded as native DXT ones
+				if (transcoded_format) {
+					uint32_t converted_size = ((width + 3) / 4) * ((height + 3) / 4) * (tex_format == SCE_GXM_TEXTURE_FORMAT_UBC1_ABGR ? 8 : 16);
+#ifndef SKIP_ERROR_HANDLING
+					if (imageSize != converted_size) {
+						SET_GL_ERROR(GL_INVALID_VALUE)
+					}
+#endif
+					transcoded_data = vglMalloc(converted_size);
+					if (!transcoded_data) {
+						SET_GL_ERROR(GL_OUT_OF_MEMORY)
+					}
+					if (!cache_key || !vgl_cache_load(cache_key, transcoded_data, converted_size, imageSize, internalFormat, width, height)) {
+						transcode_to_dxt(transcoded_data, data, width, height, transcode);
+						if (cache_key)
+							vgl_cache_store(cache_key, transcoded_data, converted_size, imageSize, internalFormat, width, height);
+					}
+					data = transcoded_data;
+					imageSize = converted_size;
+				}
+				if (tex->mip_streaming)
+					gpu_stream_compressed_mip(level, width, height, tex_format, imageSize, data, tex);
 				else
-					gpu_alloc_mipmaps(level, tex);
-				vgl_free(decompressed_data);
-			} else
-				gpu_alloc_compressed_texture(level, width, height, tex_format, imageSize, data, tex, 0, NULL);
+					gpu_alloc_compressed_texture(level, width, height, tex_format, imageSize, data, tex, 0, NULL);
+				if (transcoded_format)
+					vgl_free(transcoded_data);
+			}
 		}
 		// Setting texture parameters
 		vglSetTexUMode(&tex->gxm_tex, tex->u_mode);
@@ -1074,6 +1459,40 @@ void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, G
 	}
 }
 
+void glGetCompressedTexImage(GLenum target, GLint level, void *img) {
+	// Aliasing texture unit for cleaner code
+	texture_unit *tex_unit = &texture_units[server_texture_unit];
+	int texture2d_idx = tex_unit->tex_id;
+	texture *tex = getTexture(texture2d_idx);
+
+#ifdef HAVE_UNPURE_TEXTURES
+	if (tex->mip_start >= 0)
+		level -= tex->mip_start;
+#endif
+
+#ifndef SKIP_ERROR_HANDLING
+	if (target != GL_TEXTURE_2D) {
+		SET_GL_ERROR(GL_INVALID_ENUM)
+	}
+	if (level < 0 || level >= tex->mip_count) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	}
+	// Transcoded textures hold DXT blocks instead of the internal format ones
+	if (tex->status != TEX_VALID || tex->is_transcoded) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+#endif
+
+	waitTextureUpload(tex);
+	if (tex->staged_upload)
+		completeStagedUpload(tex);
+
+	// Unswizzling the requested mipmap into the client buffer
+	if (!gpu_read_compressed_mip(level, img, tex)) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+}
+
 void glColorTable(GLenum target, GLenum internalformat, GLsizei width, GLenum format, GLenum type, const GLvoid *data) {
 	// Checking if a color table is already enabled, if so, deallocating it
 	if (color_table != NULL) {
@@ -1105,7 +1524,7 @@ void glTexParameteri(GLenum target, GLenum pname, GLint param) {
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_CUBE_MAP:
@@ -1300,7 +1719,7 @@ void glTexParameterx(GLenum target, GLenum pname, GLfixed param) {
 		// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_CUBE_MAP:
@@ -1518,7 +1937,7 @@ void glGenerateMipmap(GLenum target) {
 	// Setting some aliases to make code more readable
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 #ifndef SKIP_ERROR_HANDLING
 	// Checking if current texture is valid
@@ -1568,10 +1987,13 @@ void *vglGetTexDataPointer(GLenum target) {
 	// Aliasing texture unit for cleaner code
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_2D:
+		waitTextureUpload(tex);
+		if (tex->staged_upload)
+			completeStagedUpload(tex);
 		return tex->data;
 	default:
 		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, NULL)
@@ -1582,7 +2004,7 @@ void vglOverloadTexDataPointer(GLenum target, void *data) {
 		// Aliasing texture unit for cleaner code
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_2D:
@@ -1593,11 +2015,48 @@ void vglOverloadTexDataPointer(GLenum target, void *data) {
 	}
 }
 
+void vglTexMipStreaming(GLenum target, GLboolean enable, GLsizei width, GLsizei height) {
+	// Aliasing texture unit for cleaner code
+	texture_unit *tex_unit = &texture_units[server_texture_unit];
+	int texture2d_idx = tex_unit->tex_id;
+	texture *tex = getTexture(texture2d_idx);
+
+	switch (target) {
+	case GL_TEXTURE_2D:
+#ifndef SKIP_ERROR_HANDLING
+		if (enable && (width <= 0 || height <= 0 || width > GXM_TEX_MAX_SIZE || height > GXM_TEX_MAX_SIZE)) {
+			SET_GL_ERROR(GL_INVALID_VALUE)
+		}
+#endif
+		tex->mip_streaming = enable;
+		tex->stream_width = width;
+		tex->stream_height = height;
+		tex->stream_levels = 0;
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	}
+}
+
+GLint vglGetTexResidentLevel(GLenum target) {
+	// Aliasing texture unit for cleaner code
+	texture_unit *tex_unit = &texture_units[server_texture_unit];
+	int texture2d_idx = tex_unit->tex_id;
+	texture *tex = getTexture(texture2d_idx);
+
+	switch (target) {
+	case GL_TEXTURE_2D:
+		return tex->stream_levels ? tex->stream_lod_min : 0;
+	default:
+		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, -1)
+	}
+}
+
 SceGxmTexture *vglGetGxmTexture(GLenum target) {
 	// Aliasing texture unit for cleaner code
 	texture_unit *tex_unit = &texture_units[server_texture_unit];
 	int texture2d_idx = tex_unit->tex_id;
-	texture *tex = &texture_slots[texture2d_idx];
+	texture *tex = getTexture(texture2d_idx);
 
 	switch (target) {
 	case GL_TEXTURE_2D:
@@ -1606,3 +2065,19 @@ SceGxmTexture *vglGetGxmTexture(GLenum target) {
 		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, NULL)
 	}
 }
+
+void vglSetTextureCache(const char *path, uint32_t max_size) {
+	vgl_cache_init(path, max_size);
+}
+
+void vglSetTextureUploadBudget(uint32_t bytes, uint32_t usecs) {
+	staged_uploads_bytes_budget = bytes;
+	staged_uploads_time_budget = usecs;
+
+	// Completing queued uploads when the queue gets disabled
+	if (!bytes && !usecs) {
+		while (staged_uploads_head) {
+			completeStagedUpload(staged_uploads_head->tex);
+		}
+	}
+}
@@ -145,40 +145,49 @@ static void atitc_decode_block(uint8_t **blockData,
     }
 }
 
-//Decode ATITC encoded data to RGBA32
-void atitc_decode(uint8_t *encodeData,             //in_data
-                 uint8_t *decodeData,              //out_data
-                 const int pixelsWidth,
-                 const int pixelsHeight,
-                 ATITCDecodeFlag decodeFlag)
+#define ATITC_JOB_ROWS 4 // Number of block rows decoded by a single job batch
+
+typedef struct {
+    uint8_t *encodeData;
+    uint8_t *decodeData;
+    int pixelsWidth;
+    ATITCDecodeFlag decodeFlag;
+} atitc_job;
+
+//Decode a range of ATITC encoded block rows to RGBA32
+static void atitc_decode_rows(void *arg, uint32_t start, uint32_t end)
 {
-    uint32_t *decodeBlockData = (uint32_t *)decodeData;
+    atitc_job *job = (atitc_job *)arg;
+    const int blocksPerRow = job->pixelsWidth / 4;
+    const int blockSize = job->decodeFlag == ATC_RGB ? 8 : 16;
+    uint8_t *encodeData = job->encodeData + start * blocksPerRow * blockSize;
 
-    for (int block_y = 0; block_y < pixelsHeight / 4; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
+    for (uint32_t block_y = start; block_y < end; ++block_y)
     {
-        for (int block_x = 0; block_x < pixelsWidth / 4; ++block_x, decodeBlockData += 4)            //skip 4 pixels
+        uint32_t *decodeBlockData = (uint32_t *)job->decodeData + block_y * 4 * job->pixelsWidth;
+        for (int block_x = 0; block_x < blocksPerRow; ++block_x, decodeBlockData += 4)            //skip 4 pixels
         {
             uint64_t blockAlpha = 0;
 
-            switch (decodeFlag)
+            switch (job->decodeFlag)
             {
                 case ATC_RGB:
                 {
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 0, 0LL, ATC_RGB);
+                    atitc_decode_block(&encodeData, decodeBlockData, job->pixelsWidth, 0, 0LL, ATC_RGB);
                 }
                     break;
                 case ATC_EXPLICIT_ALPHA:
                 {
                     memcpy((void *)&blockAlpha, encodeData, 8);
                     encodeData += 8;
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATC_EXPLICIT_ALPHA);
+                    atitc_decode_block(&encodeData, decodeBlockData, job->pixelsWidth, 1, blockAlpha, ATC_EXPLICIT_ALPHA);
                 }
                     break;
                 case ATC_INTERPOLATED_ALPHA:
                 {
                     memcpy((void *)&blockAlpha, encodeData, 8);
                     encodeData += 8;
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATC_INTERPOLATED_ALPHA);
+                    atitc_decode_block(&encodeData, decodeBlockData, job->pixelsWidth, 1, blockAlpha, ATC_INTERPOLATED_ALPHA);
                 }
                     break;
                 default:
@@ -187,3 +196,14 @@ void atitc_decode(uint8_t *encodeData,             //in_data
         }//for block_x
     }//for block_y
 }
+
+//Decode ATITC encoded data to RGBA32, block rows are spread on the worker threads
+void atitc_decode(uint8_t *encodeData,             //in_data
+                 uint8_t *decodeData,              //out_data
+                 const int pixelsWidth,
+                 const int pixelsHeight,
+                 ATITCDecodeFlag decodeFlag)
+{
+    atitc_job job = {encodeData, decodeData, pixelsWidth, decodeFlag};
+    vgl_run_jobs(atitc_decode_rows, &job, pixelsHeight / 4, ATITC_JOB_ROWS);
+}
@@ -0,0 +1,245 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * cache_utils.c:
+ * Utilities for the persistent textures cache
+ */
+#include "../shared.h"
+
+#define CACHE_INDEX_MAGIC 0x43544756 // 'VGTC'
+#define CACHE_INDEX_VERSION 2 // This must be increased whenever the index layout or the cached payloads encoding changes
+#define CACHE_INDEX_NAME "index.bin" // File name of the cache index
+#define CACHE_PATH_SIZE 256 // Max length of the cache folder path
+#define CACHE_FNAME_SIZE (CACHE_PATH_SIZE + 32) // Max length of a cache file path
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_entries;
+	uint32_t use_counter;
+} cache_header;
+
+typedef struct {
+	uint64_t key;
+	uint32_t size;
+	uint32_t last_use;
+	uint32_t src_size;
+	uint32_t format;
+	uint16_t width;
+	uint16_t height;
+} cache_entry;
+
+static char cache_path[CACHE_PATH_SIZE]; // Folder hosting the cache
+static int cache_enabled = 0; // Whether the cache is enabled
+static uint32_t cache_max_size; // Max total size of the cached payloads
+static uint32_t cache_size; // Current total size of the cached payloads
+static uint32_t cache_use_counter; // Counter used to track entries usage order
+static cache_entry *cache_entries = NULL; // Cache index entries
+static uint32_t cache_num_entries = 0; // Number of cache index entries
+static uint32_t cache_max_entries = 0; // Number of cache index entries allocated
+
+static void get_payload_path(char *fname, uint64_t key) {
+	snprintf(fname, CACHE_FNAME_SIZE, "%s/%016llX.bin", cache_path, (unsigned long long)key);
+}
+
+static void save_index(void) {
+	char fname[CACHE_FNAME_SIZE];
+	snprintf(fname, CACHE_FNAME_SIZE, "%s/%s", cache_path, CACHE_INDEX_NAME);
+	FILE *f = fopen(fname, "wb");
+	if (!f)
+		return;
+	cache_header hdr = {CACHE_INDEX_MAGIC, CACHE_INDEX_VERSION, cache_num_entries, cache_use_counter};
+	fwrite(&hdr, 1, sizeof(cache_header), f);
+	fwrite(cache_entries, sizeof(cache_entry), cache_num_entries, f);
+	fclose(f);
+}
+
+static void load_index(void) {
+	char fname[CACHE_FNAME_SIZE];
+	snprintf(fname, CACHE_FNAME_SIZE, "%s/%s", cache_path, CACHE_INDEX_NAME);
+	FILE *f = fopen(fname, "rb");
+	if (!f)
+		return;
+
+	// Indices with a different layout are discarded, stale payloads get overwritten or stay unreferenced
+	cache_header hdr;
+	if (fread(&hdr, 1, sizeof(cache_header), f) == sizeof(cache_header) && hdr.magic == CACHE_INDEX_MAGIC && hdr.version == CACHE_INDEX_VERSION) {
+		cache_entries = (cache_entry *)vglMalloc(hdr.num_entries * sizeof(cache_entry));
+		if (cache_entries) {
+			cache_max_entries = hdr.num_entries;
+			cache_num_entries = fread(cache_entries, sizeof(cache_entry), hdr.num_entries, f);
+			cache_use_counter = hdr.use_counter;
+			for (uint32_t i = 0; i < cache_num_entries; i++) {
+				cache_size += cache_entries[i].size;
+			}
+		}
+	}
+	fclose(f);
+}
+
+static void remove_entry(uint32_t idx) {
+	char fname[CACHE_FNAME_SIZE];
+	get_payload_path(fname, cache_entries[idx].key);
+	remove(fname);
+	cache_size -= cache_entries[idx].size;
+	cache_entries[idx] = cache_entries[--cache_num_entries];
+}
+
+// Evicts least recently used entries until the given extra size fits in the cache
+static void evict_entries(uint32_t extra_size) {
+	while (cache_num_entries && cache_size + extra_size > cache_max_size) {
+		uint32_t lru = 0;
+		for (uint32_t i = 1; i < cache_num_entries; i++) {
+			if (cache_entries[i].last_use < cache_entries[lru].last_use)
+				lru = i;
+		}
+		remove_entry(lru);
+	}
+}
+
+static int find_entry(uint64_t key) {
+	for (uint32_t i = 0; i < cache_num_entries; i++) {
+		if (cache_entries[i].key == key)
+			return i;
+	}
+	return -1;
+}
+
+// Checks that an entry got produced from the same source data description, guarding against hash collisions
+static int match_entry(cache_entry *e, uint32_t size, uint32_t src_size, uint32_t format, uint32_t w, uint32_t h) {
+	return e->size == size && e->src_size == src_size && e->format == format && e->width == w && e->height == h;
+}
+
+void vgl_cache_init(const char *path, uint32_t max_size) {
+	if (cache_entries) {
+		vglFree(cache_entries);
+		cache_entries = NULL;
+	}
+	cache_num_entries = 0;
+	cache_max_entries = 0;
+	cache_size = 0;
+	cache_use_counter = 0;
+	cache_enabled = path != NULL;
+	if (!cache_enabled)
+		return;
+
+	snprintf(cache_path, CACHE_PATH_SIZE, "%s", path);
+	sceIoMkdir(cache_path, 0777);
+	cache_max_size = max_size;
+	load_index();
+
+	// Shrinking the cache if the max size got lowered since last run
+	if (cache_size > cache_max_size) {
+		evict_entries(0);
+		save_index();
+	}
+}
+
+int vgl_cache_enabled(void) {
+	return cache_enabled;
+}
+
+uint64_t vgl_cache_hash(const void *data, uint32_t size, uint64_t seed) {
+	// FNV-1a over 32 bits words, trailing bytes are hashed one by one
+	const uint8_t *p = (const uint8_t *)data;
+	uint64_t h = 0xCBF29CE484222325ULL ^ seed;
+	uint32_t i;
+	for (i = 0; i + 4 <= size; i += 4) {
+		uint32_t w;
+		memcpy(&w, &p[i], 4);
+		h = (h ^ w) * 0x100000001B3ULL;
+	}
+	for (; i < size; i++) {
+		h = (h ^ p[i]) * 0x100000001B3ULL;
+	}
+	return h ^ size;
+}
+
+int vgl_cache_load(uint64_t key, void *dst, uint32_t size, uint32_t src_size, uint32_t format, uint32_t w, uint32_t h) {
+	if (!cache_enabled)
+		return 0;
+	int idx = find_entry(key);
+	if (idx < 0 || !match_entry(&cache_entries[idx], size, src_size, format, w, h))
+		return 0;
+
+	char fname[CACHE_FNAME_SIZE];
+	get_payload_path(fname, key);
+	FILE *f = fopen(fname, "rb");
+	uint32_t read_size = 0;
+	if (f) {
+		read_size = fread(dst, 1, size, f);
+		fclose(f);
+	}
+
+	// Dropping entries whose payload got lost or truncated
+	if (read_size != size) {
+		remove_entry(idx);
+		save_index();
+		return 0;
+	}
+
+	// Saving usage order so that it survives across runs
+	cache_entries[idx].last_use = ++cache_use_counter;
+	save_index();
+	return 1;
+}
+
+void vgl_cache_store(uint64_t key, const void *src, uint32_t size, uint32_t src_size, uint32_t format, uint32_t w, uint32_t h) {
+	if (!cache_enabled || size > cache_max_size)
+		return;
+	int idx = find_entry(key);
+	if (idx >= 0)
+		remove_entry(idx);
+
+	evict_entries(size);
+
+	if (cache_num_entries == cache_max_entries) {
+		uint32_t new_max = cache_max_entries ? cache_max_entries * 2 : 64;
+		cache_entry *entries = (cache_entry *)vglRealloc(cache_entries, new_max * sizeof(cache_entry));
+		if (!entries)
+			return;
+		cache_entries = entries;
+		cache_max_entries = new_max;
+	}
+
+	char fname[CACHE_FNAME_SIZE];
+	get_payload_path(fname, key);
+	FILE *f = fopen(fname, "wb");
+	uint32_t written = 0;
+	if (f) {
+		written = fwrite(src, 1, size, f);
+		fclose(f);
+	}
+	if (written != size) {
+		remove(fname);
+		save_index();
+		return;
+	}
+
+	cache_entry *e = &cache_entries[cache_num_entries++];
+	e->key = key;
+	e->size = size;
+	e->last_use = ++cache_use_counter;
+	e->src_size = src_size;
+	e->format = format;
+	e->width = w;
+	e->height = h;
+	cache_size += size;
+	save_index();
+}
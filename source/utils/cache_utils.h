@@ -0,0 +1,42 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * cache_utils.h:
+ * Header file for the persistent textures cache utilities exposed by cache_utils.c
+ */
+
+#ifndef _CACHE_UTILS_H_
+#define _CACHE_UTILS_H_
+
+// Sets up the cache in the given folder with a max total payloads size in bytes, a NULL path disables it
+void vgl_cache_init(const char *path, uint32_t max_size);
+
+// Returns 1 if the cache is enabled
+int vgl_cache_enabled(void);
+
+// Hashes data with a seed used to tell apart same data with different meanings
+uint64_t vgl_cache_hash(const void *data, uint32_t size, uint64_t seed);
+
+// Fills dst with the payload stored with the given key for the given source data description, returns 1 on success
+int vgl_cache_load(uint64_t key, void *dst, uint32_t size, uint32_t src_size, uint32_t format, uint32_t w, uint32_t h);
+
+// Stores a payload with the given key and source data description evicting the least recently used ones if needed
+void vgl_cache_store(uint64_t key, const void *src, uint32_t size, uint32_t src_size, uint32_t format, uint32_t w, uint32_t h);
+
+#endif
@@ -69,7 +69,7 @@ const uint8_t detex_clamp0to255_table[255 + 256 + 256] = {
 	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
 };
 
-static const int8_t eac_modifier_table[16][8] = {
+const int8_t eac_modifier_table[16][8] = {
 	{ -3, -6, -9, -15, 2, 5, 8, 14 },
 	{ -3, -7, -10, -13, 2, 6, 9, 12 },
 	{ -2, -5, -8, -13, 1, 4, 7, 12 },
@@ -281,38 +281,57 @@ uint32_t mode_mask, uint32_t flags, uint8_t * DETEX_RESTRICT pixel_buffer) {
 	return DecodeBlockEACSigned11Bit(green_qword, 1, 1, pixel_buffer);
 }
 
-//Decode ETC2 EAC encoded data to RGBA32
-void eac_decode(uint8_t *encodeData,             //in_data
-                 uint8_t *decodeData,              //out_data
-                 const int pixelsWidth,
-                 const int pixelsHeight,
-                 EACDecodeFlag decodeFlag)
+#define EAC_JOB_ROWS 4 // Number of block rows decoded by a single job batch
+
+typedef struct {
+	uint8_t *encodeData;
+	uint8_t *decodeData;
+	int pixelsWidth;
+	EACDecodeFlag decodeFlag;
+} eac_job;
+
+//Decode a range of ETC2 EAC encoded block rows to RGBA32
+static void eac_decode_rows(void *arg, uint32_t start, uint32_t end)
 {
-    uint32_t *decodeBlockData = (uint32_t *)decodeData;
+	eac_job *job = (eac_job *)arg;
+	const int pixelsWidth = job->pixelsWidth;
+	uint32_t *decodeBlockData = (uint32_t *)job->decodeData;
+	uint8_t *encodeData = job->encodeData + start * (pixelsWidth / 4) * 16;
 
-    for (int block_y = 0; block_y < pixelsHeight / 4; ++block_y)   //stride = 3*width
-    {
+	for (uint32_t block_y = start; block_y < end; ++block_y)
+	{
 		uint32_t y = block_y * 4;
-        for (int block_x = 0; block_x < pixelsWidth / 4; ++block_x)            //skip 4 pixels
-        {
+		for (int block_x = 0; block_x < pixelsWidth / 4; ++block_x)            //skip 4 pixels
+		{
 			uint32_t x = block_x * 4;
 			uint32_t blockData[16];
-			
-            switch (decodeFlag)
-            {
-                case EAC_ETC2:
-                {
+
+			switch (job->decodeFlag)
+			{
+				case EAC_ETC2:
+				{
 					detexDecompressBlockETC2_EAC(encodeData, DETEX_MODE_MASK_ALL, 0, blockData);
 					sceClibMemcpy(&decodeBlockData[y * pixelsWidth + x], blockData, 4 * sizeof(uint32_t));
 					sceClibMemcpy(&decodeBlockData[(y + 1) * pixelsWidth + x], &blockData[4], 4 * sizeof(uint32_t));
 					sceClibMemcpy(&decodeBlockData[(y + 2) * pixelsWidth + x], &blockData[8], 4 * sizeof(uint32_t));
 					sceClibMemcpy(&decodeBlockData[(y + 3) * pixelsWidth + x], &blockData[12], 4 * sizeof(uint32_t));
-                    encodeData += 16;
-                }
-                    break;
-                default:
-                    break;
-            }//switch
-        }//for block_x
-    }//for block_y
+					encodeData += 16;
+				}
+					break;
+				default:
+					break;
+			}//switch
+		}//for block_x
+	}//for block_y
+}
+
+//Decode ETC2 EAC encoded data to RGBA32, block rows are spread on the worker threads
+void eac_decode(uint8_t *encodeData,             //in_data
+                 uint8_t *decodeData,              //out_data
+                 const int pixelsWidth,
+                 const int pixelsHeight,
+                 EACDecodeFlag decodeFlag)
+{
+	eac_job job = {encodeData, decodeData, pixelsWidth, decodeFlag};
+	vgl_run_jobs(eac_decode_rows, &job, pixelsHeight / 4, EAC_JOB_ROWS);
 }
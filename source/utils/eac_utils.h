@@ -29,6 +29,9 @@ void eac_decode(uint8_t *encodeData,             //in_data
                  const int pixelsHeight,
                  EACDecodeFlag decodeFlag);
 
+// EAC modifiers, indexed by table codeword and pixel index
+extern const int8_t eac_modifier_table[16][8];
+
 #undef __BEGIN_DECLS
 #undef __END_DECLS
 #ifdef __cplusplus
@@ -13,6 +13,18 @@
 // limitations under the License.
 #include "../shared.h"
 
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+
+// Per pixel masks selecting the second subblock colors, pixels are indexed as (x + 4 * y)
+static const uint16_t kSecondSubblockMask[2][16] = {
+    { 0, 0, 0xFFFF, 0xFFFF, 0, 0, 0xFFFF, 0xFFFF, 0, 0, 0xFFFF, 0xFFFF, 0, 0, 0xFFFF, 0xFFFF },
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF }
+};
+#endif
+
+#define ETC1_JOB_ROWS 4 // Number of block rows decoded by a single job batch
+
 static const int kModifierTable[] = {
 /* 0 */2, 8, -2, -8,
 /* 1 */5, 17, -5, -17,
@@ -125,28 +137,55 @@ void etc1_decode_block(const etc1_byte* pIn, etc1_byte* pOut) {
     const int* tableA = kModifierTable + tableIndexA * 4;
     const int* tableB = kModifierTable + tableIndexB * 4;
     int flipped = (high & 1) != 0;
+#ifdef __ARM_NEON__
+    // Gathering per pixel modifiers, then adding and clamping them to subblocks colors for the whole block at once
+    int16_t delta[16];
+    for (int p = 0; p < 16; p++) {
+        int k = (p >> 2) + ((p & 3) * 4);
+        int offset = ((low >> k) & 1) | ((low >> (k + 15)) & 2);
+        int second = flipped ? (p >> 3) : ((p >> 1) & 1);
+        delta[p] = second ? tableB[offset] : tableA[offset];
+    }
+    int16x8_t d_lo = vld1q_s16(delta);
+    int16x8_t d_hi = vld1q_s16(delta + 8);
+    uint16x8_t m_lo = vld1q_u16(kSecondSubblockMask[flipped]);
+    uint16x8_t m_hi = vld1q_u16(kSecondSubblockMask[flipped] + 8);
+    uint8x16x3_t out;
+    out.val[0] = vcombine_u8(vqmovun_s16(vaddq_s16(vbslq_s16(m_lo, vdupq_n_s16(r2), vdupq_n_s16(r1)), d_lo)),
+        vqmovun_s16(vaddq_s16(vbslq_s16(m_hi, vdupq_n_s16(r2), vdupq_n_s16(r1)), d_hi)));
+    out.val[1] = vcombine_u8(vqmovun_s16(vaddq_s16(vbslq_s16(m_lo, vdupq_n_s16(g2), vdupq_n_s16(g1)), d_lo)),
+        vqmovun_s16(vaddq_s16(vbslq_s16(m_hi, vdupq_n_s16(g2), vdupq_n_s16(g1)), d_hi)));
+    out.val[2] = vcombine_u8(vqmovun_s16(vaddq_s16(vbslq_s16(m_lo, vdupq_n_s16(b2), vdupq_n_s16(b1)), d_lo)),
+        vqmovun_s16(vaddq_s16(vbslq_s16(m_hi, vdupq_n_s16(b2), vdupq_n_s16(b1)), d_hi)));
+    vst3q_u8(pOut, out);
+#else
     decode_subblock(pOut, r1, g1, b1, tableA, low, 0, flipped);
     decode_subblock(pOut, r2, g2, b2, tableB, low, 1, flipped);
+#endif
 }
 
 
-// Decode an entire image.
-// pIn - pointer to encoded data.
-// pOut - pointer to the image data. Will be written such that the Red component of
-//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset. Must be
-//        large enough to store entire image.
-int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
-        etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 pixelSize, etc1_uint32 stride) {
-    if (pixelSize < 2 || pixelSize > 3) {
-        return -1;
-    }
+typedef struct {
+    const etc1_byte* pIn;
+    etc1_byte* pOut;
+    etc1_uint32 width;
+    etc1_uint32 height;
+    etc1_uint32 pixelSize;
+    etc1_uint32 stride;
+} etc1_job;
+
+// Decode a range of block rows of an image.
+static void etc1_decode_rows(void* arg, uint32_t start, uint32_t end) {
+    etc1_job* job = (etc1_job*) arg;
     etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
 
+    etc1_uint32 width = job->width;
+    etc1_uint32 height = job->height;
+    etc1_uint32 pixelSize = job->pixelSize;
     etc1_uint32 encodedWidth = (width + 3) & ~3;
-    etc1_uint32 encodedHeight = (height + 3) & ~3;
+    const etc1_byte* pIn = job->pIn + start * (encodedWidth / 4) * ETC1_ENCODED_BLOCK_SIZE;
 
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
+    for (etc1_uint32 y = start * 4; y < end * 4; y += 4) {
         etc1_uint32 yEnd = height - y;
         if (yEnd > 4) {
             yEnd = 4;
@@ -160,7 +199,7 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
             pIn += ETC1_ENCODED_BLOCK_SIZE;
             for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
                 const etc1_byte* q = block + (cy * 4) * 3;
-                etc1_byte* p = pOut + pixelSize * x + stride * (y + cy);
+                etc1_byte* p = job->pOut + pixelSize * x + job->stride * (y + cy);
                 if (pixelSize == 3) {
                     memcpy(p, q, xEnd * 3);
                 } else {
@@ -176,5 +215,21 @@ int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
             }
         }
     }
+}
+
+// Decode an entire image, block rows are spread on the worker threads.
+// pIn - pointer to encoded data.
+// pOut - pointer to the image data. Will be written such that the Red component of
+//       pixel (x,y) is at pIn + pixelSize * x + stride * y + redOffset. Must be
+//        large enough to store entire image.
+int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride) {
+    if (pixelSize < 2 || pixelSize > 3) {
+        return -1;
+    }
+
+    etc1_job job = { pIn, pOut, width, height, pixelSize, stride };
+    vgl_run_jobs(etc1_decode_rows, &job, (height + 3) / 4, ETC1_JOB_ROWS);
     return 0;
 }
@@ -23,6 +23,10 @@
 
 #include "../shared.h"
 
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
 #define STB_DXT_IMPLEMENTATION
 #include "stb_dxt.h"
 
@@ -73,12 +77,23 @@ void extract_block(const uint8_t *src, int width, uint8_t *block) {
 	}
 }
 
-void dxt_compress(uint8_t *dst, uint8_t *src, int w, int h, int isdxt5) {
+#define DXT_JOB_BLOCKS 256 // Number of Morton ordered blocks compressed by a single job unit
+
+typedef struct {
+	uint8_t *dst;
+	uint8_t *src;
+	int w;
+	int h;
+	int isdxt5;
+	uint32_t num_blocks;
+	uint32_t *offsets; // Number of compressed blocks preceding every job unit
+	uint32_t first_unit; // Job unit mapped to the first unit index passed to the callback
+} dxt_job;
+
+static void dxt_compress_range(uint8_t *dst, uint8_t *src, int w, int h, int isdxt5, uint64_t start, uint64_t end) {
 	uint8_t block[64];
-	int s = MAX(w, h);
-	uint32_t num_blocks = (s * s) / 16;
 	uint64_t d, offs_x, offs_y;
-	for (d = 0; d < num_blocks; d++) {
+	for (d = start; d < end; d++) {
 		d2xy_morton(d, &offs_x, &offs_y);
 		if (offs_x * 4 >= h)
 			continue;
@@ -90,6 +105,43 @@ void dxt_compress(uint8_t *dst, uint8_t *src, int w, int h, int isdxt5) {
 	}
 }
 
+static void dxt_compress_job(void *arg, uint32_t start, uint32_t end) {
+	dxt_job *j = (dxt_job *)arg;
+	for (uint32_t i = start + j->first_unit; i < end + j->first_unit; i++) {
+		uint64_t last = (i + 1) * DXT_JOB_BLOCKS;
+		dxt_compress_range(j->dst + j->offsets[i] * (j->isdxt5 ? 16 : 8), j->src, j->w, j->h, j->isdxt5, i * DXT_JOB_BLOCKS, last < j->num_blocks ? last : j->num_blocks);
+	}
+}
+
+void dxt_compress(uint8_t *dst, uint8_t *src, int w, int h, int isdxt5) {
+	int s = MAX(w, h);
+	uint32_t num_blocks = (s * s) / 16;
+	uint32_t num_units = (num_blocks + DXT_JOB_BLOCKS - 1) / DXT_JOB_BLOCKS;
+	uint32_t *offsets = num_units > 1 ? (uint32_t *)vglMalloc(num_units * sizeof(uint32_t)) : NULL;
+	if (!offsets) {
+		dxt_compress_range(dst, src, w, h, isdxt5, 0, num_blocks);
+		return;
+	}
+
+	// Blocks outside of the texture are skipped, so we count the ones preceding every job unit to know where its output starts
+	uint32_t compressed = 0;
+	uint64_t d, offs_x, offs_y;
+	for (d = 0; d < num_blocks; d++) {
+		if (d % DXT_JOB_BLOCKS == 0)
+			offsets[d / DXT_JOB_BLOCKS] = compressed;
+		d2xy_morton(d, &offs_x, &offs_y);
+		if (offs_x * 4 < h && offs_y * 4 < w)
+			compressed++;
+	}
+
+	// First unit is compressed on the calling thread alone so that stb_dxt lookup tables get initialized before workers start
+	dxt_job job = {dst, src, w, h, isdxt5, num_blocks, offsets, 0};
+	dxt_compress_job(&job, 0, 1);
+	job.first_unit = 1;
+	vgl_run_jobs(dxt_compress_job, &job, num_units - 1, 1);
+	vglFree(offsets);
+}
+
 enum {
 	SWIZZLER_DEFAULT = 0x00,
 	SWIZZLER_LARGE_BLOCK = 0x01,
@@ -97,7 +149,35 @@ enum {
 	SWIZZLER_ENDIANESS_SWAP = 0x04
 };
 
-void swizzle_compressed_texture_region(void *dst, const void *src, int tex_width, int tex_height, int region_x, int region_y, int region_width, int region_height, int mode) {
+static inline uint32_t morton_spread(uint32_t x) {
+	x &= 0x0000FFFF;
+	x = (x | (x << 8)) & 0x00FF00FF;
+	x = (x | (x << 4)) & 0x0F0F0F0F;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+static inline void copy_compressed_block(uint8_t *dst, const uint8_t *src, int blocksize, int mode) {
+	if (mode & SWIZZLER_ENDIANESS_SWAP) {
+		uint32_t words[4];
+		__builtin_memcpy(words, src, blocksize);
+		for (int i = 0; i < blocksize / 4; i++) {
+			words[i] = __builtin_bswap32(words[i]);
+		}
+		__builtin_memcpy(dst, words, blocksize);
+	} else if (blocksize == 16) {
+#ifdef __ARM_NEON__
+		vst1q_u8(dst, vld1q_u8(src));
+#else
+		__builtin_memcpy(dst, src, 16);
+#endif
+	} else
+		__builtin_memcpy(dst, src, 8);
+}
+
+// Copies blocks between a linear compressed region and a swizzled compressed texture, texture sizes must be powers of two
+static void copy_compressed_texture_region(uint8_t *swizzled, uint8_t *linear, int tex_width, int tex_height, int region_x, int region_y, int region_width, int region_height, int mode, GLboolean unswizzle) {
 	const int blocksize = (mode & SWIZZLER_LARGE_BLOCK) ? 16 : 8;
 	const uint32_t blockw = (mode & SWIZZLER_WIDE_BLOCK) ? 8 : 4;
 
@@ -107,40 +187,56 @@ void swizzle_compressed_texture_region(void *dst, const void *src, int tex_width
 	region_width = ALIGN(region_width, blockw);
 	region_height = ALIGN(region_height, 4);
 
-	const int s = MAX(tex_width, tex_height);
-	const uint32_t num_blocks = (s * s) / (blockw * 4);
+	const uint32_t blocks_w = tex_width / blockw;
+	const uint32_t blocks_h = tex_height / 4;
+	const uint32_t first_row = region_y / 4;
+	const uint32_t first_col = region_x / blockw;
+	uint32_t num_rows = region_height / 4;
+	uint32_t num_cols = region_width / blockw;
+	if (first_row + num_rows > blocks_h)
+		num_rows = first_row < blocks_h ? blocks_h - first_row : 0;
+	if (first_col + num_cols > blocks_w)
+		num_cols = first_col < blocks_w ? blocks_w - first_col : 0;
+	if (!num_rows || !num_cols)
+		return;
+
+	// Morton order restricted to a power of two texture interleaves block coords bits up to the smaller side and then
+	// appends the remaining bits of the larger one, so a block offset is the sum of a row term and a column term
+	const uint32_t square = blocks_w < blocks_h ? blocks_w : blocks_h;
+	const uint32_t high_shift = __builtin_ctz(square) * 2;
+	static uint32_t row_offs[GXM_TEX_MAX_SIZE / 4];
+	static uint32_t col_offs[GXM_TEX_MAX_SIZE / 4];
+	for (uint32_t i = 0; i < num_rows; i++) {
+		uint32_t r = first_row + i;
+		row_offs[i] = (morton_spread(r & (square - 1)) | ((r / square) << high_shift)) * blocksize;
+	}
+	for (uint32_t i = 0; i < num_cols; i++) {
+		uint32_t c = first_col + i;
+		col_offs[i] = ((morton_spread(c & (square - 1)) << 1) | ((c / square) << high_shift)) * blocksize;
+	}
 
-	uint64_t d, offs_x, offs_y;
-	uint64_t dst_x, dst_y;
-	for (d = 0; d < num_blocks; d++) {
-		d2xy_morton(d, &offs_x, &offs_y);
-		// If the block coords exceed input texture dimensions.
-		if ((offs_x * 4 >= region_height + region_y) || (offs_x * 4 < region_y)) {
-			// If the block coord is smaller than the Po2 aligned dimension, skip forward one block.
-			if (offs_x * 4 < tex_height)
-				dst += blocksize;
-			continue;
+	const uint32_t linear_stride = (region_width / blockw) * blocksize;
+	for (uint32_t i = 0; i < num_rows; i++) {
+		uint8_t *swizzled_row = swizzled + row_offs[i];
+		uint8_t *linear_row = linear + i * linear_stride;
+		if (unswizzle) {
+			for (uint32_t j = 0; j < num_cols; j++) {
+				copy_compressed_block(linear_row + j * blocksize, swizzled_row + col_offs[j], blocksize, mode);
+			}
+		} else {
+			for (uint32_t j = 0; j < num_cols; j++) {
+				copy_compressed_block(swizzled_row + col_offs[j], linear_row + j * blocksize, blocksize, mode);
+			}
 		}
+	}
+}
 
-		if ((offs_y * blockw >= region_width + region_x) || (offs_y * blockw < region_x)) {
-			if (offs_y * blockw < tex_width)
-				dst += blocksize;
-			continue;
-		}
+void swizzle_compressed_texture_region(void *dst, const void *src, int tex_width, int tex_height, int region_x, int region_y, int region_width, int region_height, int mode) {
+	copy_compressed_texture_region((uint8_t *)dst, (uint8_t *)src, tex_width, tex_height, region_x, region_y, region_width, region_height, mode, GL_FALSE);
+}
 
-		dst_x = offs_x - (region_y / 4);
-		dst_y = offs_y - (region_x / blockw);
-		
-		if (mode & SWIZZLER_ENDIANESS_SWAP) {
-			uint32_t *block_src = (uint32_t *)(src + dst_y * blocksize + dst_x * (region_width / blockw) * blocksize);
-			uint32_t *block_dst = dst;
-			for (int i = 0; i < blocksize / 4; i++) {
-				block_dst[i] = __builtin_bswap32(block_src[i]);
-			}
-		} else
-			vgl_fast_memcpy(dst, src + dst_y * blocksize + dst_x * (region_width / blockw) * blocksize, blocksize);
-		dst += blocksize;
-	}
+void unswizzle_compressed_texture_region(void *dst, const void *src, int tex_width, int tex_height, int region_x, int region_y, int region_width, int region_height, int mode) {
+	copy_compressed_texture_region((uint8_t *)src, (uint8_t *)dst, tex_width, tex_height, region_x, region_y, region_width, region_height, mode, GL_TRUE);
 }
 
 static int unsafe_allocator_counter = 0;
@@ -362,6 +458,10 @@ void *gpu_alloc_palette(const void *data, uint32_t w, uint32_t bpe) {
 }
 
 void gpu_free_texture_data(texture *tex) {
+	// Dropping any upload still queued for the texture
+	if (tex->staged_upload)
+		cancelStagedUpload(tex);
+
 	// Deallocating texture
 	if (tex->data != NULL) {
 		markAsDirty(tex->data);
@@ -371,11 +471,13 @@ void gpu_free_texture_data(texture *tex) {
 		markAsDirty(tex->palette_data);
 		tex->palette_data = NULL;
 	}
+	tex->stream_levels = 0;
 }
 
 void gpu_free_texture(texture *tex) {
 	gpu_free_texture_data(tex);
 	tex->status = TEX_UNUSED;
+	releaseTextureName(tex->id);
 }
 
 void gpu_alloc_cube_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, SceGxmTransferFormat src_format, const void *data, texture *tex, uint8_t src_bpp, int index) {
@@ -421,7 +523,69 @@ void gpu_alloc_cube_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format,
 	}
 }
 
-void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store) {
+GLboolean gpu_transfer_texture_data(texture *tex, SceGxmTextureFormat format, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const void *src, uint32_t src_stride) {
+	// Checking if the transfer engine can perform the copy as is
+	switch (format & 0x9F000000) {
+	case SCE_GXM_TEXTURE_BASE_FORMAT_U1U5U5U5:
+	case SCE_GXM_TEXTURE_BASE_FORMAT_U5U6U5:
+	case SCE_GXM_TEXTURE_BASE_FORMAT_U4U4U4U4:
+	case SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8:
+	case SCE_GXM_TEXTURE_BASE_FORMAT_U8U8U8U8:
+		break;
+	default:
+		return GL_FALSE;
+	}
+	uint32_t dst_stride = ALIGN(sceGxmTextureGetWidth(&tex->gxm_tex), 8) * tex_format_to_bytespp(format);
+	if (((uint32_t)src | src_stride) & 3)
+		return GL_FALSE;
+
+	// Queueing the copy, texture usage will wait for the notification to be signaled
+	SceGxmNotification notification;
+	uint32_t fence = getTransferNotification(&notification);
+	SceGxmTransferFormat fmt = tex_format_to_transfer(format);
+	if (sceGxmTransferCopy(
+		w, h, 0, 0, SCE_GXM_TRANSFER_COLORKEY_NONE,
+		fmt, SCE_GXM_TRANSFER_LINEAR,
+		(void *)src, 0, 0, src_stride,
+		fmt, SCE_GXM_TRANSFER_LINEAR,
+		tex->data, x, y, dst_stride,
+		NULL, 0, &notification))
+		return GL_FALSE;
+	tex->upload_fence = fence;
+	return GL_TRUE;
+}
+
+void gpu_store_texture_lines(void *dst, uint32_t dst_stride, const void *src, uint32_t w, uint32_t h, uint8_t bpp, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store) {
+	int i, j;
+	uint8_t *s = (uint8_t *)src;
+	uint8_t *d;
+	if (fast_store) { // Internal Format and Data Format are the same, we can just use vgl_fast_memcpy for better performance
+		uint32_t line_size = w * bpp;
+		for (i = 0; i < h; i++) {
+			d = (uint8_t *)dst + dst_stride * i;
+			vgl_fast_memcpy(d, s, line_size);
+			s += line_size;
+		}
+	} else { // Different internal and data formats, we need to convert pixels
+		convert_cb convert = getConvertCallback(read_cb, write_cb);
+		for (i = 0; i < h; i++) {
+			d = (uint8_t *)dst + dst_stride * i;
+			if (convert) { // A specialized kernel is available for this formats pair
+				convert(d, s, w);
+				s += w * src_bpp;
+			} else { // Falling back to slower callbacks system
+				for (j = 0; j < w; j++) {
+					uint32_t clr = read_cb(s);
+					write_cb(d, clr);
+					s += src_bpp;
+					d += bpp;
+				}
+			}
+		}
+	}
+}
+
+void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store, GLboolean gpu_src) {
 	// If there's already a texture in passed texture object we first dealloc it
 	if (tex->status == TEX_VALID)
 		gpu_free_texture_data(tex);
@@ -435,36 +599,6 @@ void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const
 	void *texture_data = gpu_alloc_mapped(tex_size, use_vram ? VGL_MEM_VRAM : VGL_MEM_RAM);
 
 	if (texture_data != NULL) {
-		// Initializing texture data buffer
-		if (data != NULL) {
-			int i, j;
-			uint8_t *src = (uint8_t *)data;
-			uint8_t *dst;
-			if (fast_store) { // Internal Format and Data Format are the same, we can just use vgl_fast_memcpy for better performance
-				if (aligned_w == w) // Texture size is already aligned, we can use a single vgl_fast_memcpy for better performance
-					vgl_fast_memcpy(texture_data, src, tex_size);
-				else {
-					uint32_t line_size = w * bpp;
-					for (i = 0; i < h; i++) {
-						dst = ((uint8_t *)texture_data) + (ALIGN(w, 8) * bpp) * i;
-						vgl_fast_memcpy(dst, src, line_size);
-						src += line_size;
-					}
-				}
-			} else { // Different internal and data formats, we need to go with slower callbacks system
-				for (i = 0; i < h; i++) {
-					dst = ((uint8_t *)texture_data) + (ALIGN(w, 8) * bpp) * i;
-					for (j = 0; j < w; j++) {
-						uint32_t clr = read_cb(src);
-						write_cb(dst, clr);
-						src += src_bpp;
-						dst += bpp;
-					}
-				}
-			}
-		} else
-			sceClibMemset(texture_data, 0, tex_size);
-
 		// Initializing texture and validating it
 		tex->mip_count = 1;
 		vglInitLinearTexture(&tex->gxm_tex, texture_data, format, w, h, tex->mip_count);
@@ -474,6 +608,18 @@ void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const
 			tex->palette_data = NULL;
 		tex->status = TEX_VALID;
 		tex->data = texture_data;
+		tex->upload_fence = 0;
+
+		// Initializing texture data buffer
+		if (data != NULL) {
+			if (fast_store && gpu_src && gpu_transfer_texture_data(tex, format, 0, 0, w, h, data, w * bpp)) {
+				// Source data is already sceGxm mapped, the copy has been queued on the transfer engine
+			} else if (fast_store && aligned_w == w) // Texture size is already aligned, we can use a single vgl_fast_memcpy for better performance
+				vgl_fast_memcpy(texture_data, data, tex_size);
+			else
+				gpu_store_texture_lines(texture_data, aligned_w * bpp, data, w, h, bpp, src_bpp, read_cb, write_cb, fast_store);
+		} else
+			sceClibMemset(texture_data, 0, tex_size);
 	}
 }
 
@@ -566,6 +712,117 @@ int gpu_get_compressed_mip_offset(int level, int width, int height, SceGxmTextur
 	return gpu_get_compressed_mipchain_size(level - 1, width, height, format);
 }
 
+static void store_compressed_mip(void *mip_data, const void *data, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size) {
+	const uint32_t aligned_width = nearest_po2(w);
+	const uint32_t aligned_height = nearest_po2(h);
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_1BGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_1BGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR:
+		vgl_fast_memcpy(mip_data, data, image_size);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR:
+		swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_LARGE_BLOCK);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_PVRTII2BPP_ABGR:
+		swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_WIDE_BLOCK);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_ETC1_RGB:
+		swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_ENDIANESS_SWAP);
+		break;
+	default:
+		swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_DEFAULT);
+		break;
+	}
+}
+
+static void load_compressed_mip(void *data, const void *mip_data, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size) {
+	const uint32_t aligned_width = nearest_po2(w);
+	const uint32_t aligned_height = nearest_po2(h);
+	switch (format) {
+	case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_1BGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_1BGR:
+	case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR:
+		vgl_fast_memcpy(data, mip_data, image_size);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR:
+	case SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR:
+		unswizzle_compressed_texture_region(data, mip_data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_LARGE_BLOCK);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_PVRTII2BPP_ABGR:
+		unswizzle_compressed_texture_region(data, mip_data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_WIDE_BLOCK);
+		break;
+	case SCE_GXM_TEXTURE_FORMAT_ETC1_RGB:
+		unswizzle_compressed_texture_region(data, mip_data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_ENDIANESS_SWAP);
+		break;
+	default:
+		unswizzle_compressed_texture_region(data, mip_data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_DEFAULT);
+		break;
+	}
+}
+
+GLboolean gpu_read_compressed_mip(int32_t level, void *dst, texture *tex) {
+	const SceGxmTextureFormat format = sceGxmTextureGetFormat(&tex->gxm_tex);
+
+	const uint32_t w = sceGxmTextureGetWidth(&tex->gxm_tex);
+	const uint32_t h = sceGxmTextureGetHeight(&tex->gxm_tex);
+	const uint32_t mip_w = MAX(w >> level, 1);
+	const uint32_t mip_h = MAX(h >> level, 1);
+	const uint32_t mip_size = gpu_get_compressed_mip_size(level, mip_w, mip_h, format);
+	if (!mip_size)
+		return GL_FALSE;
+
+	const uint8_t *mip_data = (uint8_t *)tex->data + gpu_get_compressed_mip_offset(level, nearest_po2(w), nearest_po2(h), format);
+	load_compressed_mip(dst, mip_data, mip_w, mip_h, format, mip_size);
+	return GL_TRUE;
+}
+
+void gpu_stream_compressed_mip(int32_t level, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size, const void *data, texture *tex) {
+	if (!image_size)
+		image_size = gpu_get_compressed_mip_size(level, w, h, format);
+
+	// Allocating the whole mipchain at the first uploaded level, base level size is the one set with vglTexMipStreaming
+	const uint32_t aligned_max_width = nearest_po2(tex->stream_width);
+	const uint32_t aligned_max_height = nearest_po2(tex->stream_height);
+	if (tex->status != TEX_VALID || !tex->stream_levels || sceGxmTextureGetFormat(&tex->gxm_tex) != format) {
+		if (tex->status == TEX_VALID)
+			gpu_free_texture_data(tex);
+		uint8_t levels = 1;
+		while ((tex->stream_width >> levels) || (tex->stream_height >> levels))
+			levels++;
+		const int tex_size = gpu_get_compressed_mipchain_size(levels - 1, aligned_max_width, aligned_max_height, format);
+		void *texture_data = gpu_alloc_mapped(tex_size, use_vram ? VGL_MEM_VRAM : VGL_MEM_RAM);
+		if (!texture_data)
+			return;
+		sceClibMemset(texture_data, 0, tex_size);
+		tex->data = texture_data;
+		tex->palette_data = NULL;
+		tex->upload_fence = 0;
+		tex->status = TEX_VALID;
+		tex->stream_levels = levels;
+		tex->resident_mips = 0;
+		tex->mip_count = levels;
+		vglInitSwizzledTexture(&tex->gxm_tex, texture_data, format, tex->stream_width, tex->stream_height, tex->use_mips ? tex->mip_count : 0);
+	}
+
+	// Storing the uploaded level in its mipchain slot
+	uint8_t *mip_data = (uint8_t *)tex->data + gpu_get_compressed_mip_offset(level, aligned_max_width, aligned_max_height, format);
+	store_compressed_mip(mip_data, data, w, h, format, image_size);
+	tex->resident_mips |= (1 << level);
+
+	// Sampling is clamped to the largest level having every smaller level resident
+	int first = tex->stream_levels;
+	while (first > 0 && (tex->resident_mips & (1 << (first - 1))))
+		first--;
+	if (first == tex->stream_levels) // Smallest level is still missing, sampling blank data from it
+		first--;
+	tex->stream_lod_min = first;
+	sceGxmTextureSetLodMin(&tex->gxm_tex, first);
+}
+
 void gpu_alloc_compressed_texture(int32_t mip_level, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *)) {
 	// If there's already a texture in passed texture object we first dealloc it
 	if (tex->status == TEX_VALID && !mip_level)
@@ -655,30 +912,8 @@ void gpu_alloc_compressed_texture(int32_t mip_level, uint32_t w, uint32_t h, Sce
 				// Freeing temporary data if necessary
 				if (read_cb != readRGBA)
 					vgl_free(temp);
-			} else {
-				// Perform swizzling if necessary.
-				switch (format) {
-				case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_1BGR:
-				case SCE_GXM_TEXTURE_FORMAT_PVRT2BPP_ABGR:
-				case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_1BGR:
-				case SCE_GXM_TEXTURE_FORMAT_PVRT4BPP_ABGR:
-					vgl_fast_memcpy(mip_data, data, image_size);
-					break;
-				case SCE_GXM_TEXTURE_FORMAT_UBC2_ABGR:
-				case SCE_GXM_TEXTURE_FORMAT_UBC3_ABGR:
-					swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_LARGE_BLOCK);
-					break;
-				case SCE_GXM_TEXTURE_FORMAT_PVRTII2BPP_ABGR:
-					swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_WIDE_BLOCK);
-					break;
-				case SCE_GXM_TEXTURE_FORMAT_ETC1_RGB:
-					swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_ENDIANESS_SWAP);
-					break;
-				default:
-					swizzle_compressed_texture_region(mip_data, (void *)data, aligned_width, aligned_height, 0, 0, w, h, SWIZZLER_DEFAULT);
-					break;
-				}
-			}
+			} else // Perform swizzling if necessary.
+				store_compressed_mip(mip_data, data, w, h, format, image_size);
 
 		} else
 			sceClibMemset(mip_data, 0, mip_size);
@@ -693,6 +928,10 @@ void gpu_alloc_compressed_texture(int32_t mip_level, uint32_t w, uint32_t h, Sce
 }
 
 void gpu_alloc_mipmaps(int level, texture *tex) {
+	// Mipmaps are generated from the base level, so it must be fully uploaded
+	if (tex->staged_upload)
+		completeStagedUpload(tex);
+
 	// Getting current mipmap count in passed texture
 	uint32_t count = tex->mip_count - 1;
 
@@ -41,6 +41,7 @@ typedef struct {
 	SceGxmTexture gxm_tex;
 	void *data;
 	void *palette_data;
+	GLuint id;
 	uint8_t status;
 	uint32_t type;
 	void (*write_cb)(void *, uint32_t);
@@ -55,6 +56,15 @@ typedef struct {
 	uint8_t ref_counter;
 	uint8_t faces_counter;
 	GLboolean dirty;
+	uint32_t upload_fence;
+	void *staged_upload;
+	GLboolean mip_streaming;
+	uint8_t stream_levels;
+	uint8_t stream_lod_min;
+	GLboolean is_transcoded;
+	uint16_t resident_mips;
+	uint16_t stream_width;
+	uint16_t stream_height;
 #ifdef HAVE_UNPURE_TEXTURES
 	int8_t mip_start;
 #endif
@@ -85,7 +95,13 @@ void gpu_fragment_usse_free_mapped(void *addr);
 int tex_format_to_bytespp(SceGxmTextureFormat format);
 
 // Alloc a texture
-void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store);
+void gpu_alloc_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store, GLboolean gpu_src);
+
+// Store lines of pixel data into a linear texture, converting them if required
+void gpu_store_texture_lines(void *dst, uint32_t dst_stride, const void *src, uint32_t w, uint32_t h, uint8_t bpp, uint8_t src_bpp, uint32_t (*read_cb)(void *), void (*write_cb)(void *, uint32_t), GLboolean fast_store);
+
+// Queue a copy of sceGxm mapped pixel data into a linear texture on the transfer engine
+GLboolean gpu_transfer_texture_data(texture *tex, SceGxmTextureFormat format, uint32_t x, uint32_t y, uint32_t w, uint32_t h, const void *src, uint32_t src_stride);
 
 // Alloc a cube texture
 void gpu_alloc_cube_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format, SceGxmTransferFormat src_format, const void *data, texture *tex, uint8_t src_bpp, int index);
@@ -93,9 +109,15 @@ void gpu_alloc_cube_texture(uint32_t w, uint32_t h, SceGxmTextureFormat format,
 // Alloc a compresseed texture
 void gpu_alloc_compressed_texture(int32_t level, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *));
 
+// Store a compressed texture mip in a progressively streamed mipchain
+void gpu_stream_compressed_mip(int32_t level, uint32_t w, uint32_t h, SceGxmTextureFormat format, uint32_t image_size, const void *data, texture *tex);
+
 // Alloc a paletted texture
 void gpu_alloc_paletted_texture(int32_t level, uint32_t w, uint32_t h, SceGxmTextureFormat format, const void *data, texture *tex, uint8_t src_bpp, uint32_t (*read_cb)(void *));
 
+// Copy a mipmap of a compressed texture to a linear buffer, returns GL_FALSE if the texture is not compressed
+GLboolean gpu_read_compressed_mip(int32_t level, void *dst, texture *tex);
+
 // Dealloc a texture
 void gpu_free_texture(texture *tex);
 
@@ -0,0 +1,99 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * job_utils.c:
+ * Utilities to spread CPU heavy work on the spare cores
+ */
+#include "../shared.h"
+
+#define JOB_WORKERS_NUM 2 // Number of worker threads, one per spare user core
+#define JOB_WORKER_STACK_SIZE 0x10000 // Stack size in bytes of a worker thread
+
+static SceUID job_workers[JOB_WORKERS_NUM]; // Worker threads
+static SceUID job_start_sema; // Semaphore used to wake the worker threads up
+static SceUID job_done_sema; // Semaphore signaled by the worker threads once the current job is completed
+static SceKernelLwMutexWork job_mutex; // Mutex held by the thread currently owning the worker threads
+static GLboolean job_workers_ready = GL_FALSE; // Whether worker threads got created
+
+static job_cb job_func; // Callback of the current job
+static void *job_arg; // Argument of the current job
+static uint32_t job_count; // Number of units of the current job
+static uint32_t job_grain; // Number of units processed by a single batch of the current job
+static volatile uint32_t job_next; // First unit of the next batch to process
+
+static void process_job_batches(void) {
+	uint32_t start;
+	while ((start = __atomic_fetch_add(&job_next, job_grain, __ATOMIC_RELAXED)) < job_count) {
+		uint32_t end = start + job_grain;
+		job_func(job_arg, start, end < job_count ? end : job_count);
+	}
+}
+
+static int job_worker(SceSize args, void *argp) {
+	for (;;) {
+		sceKernelWaitSema(job_start_sema, 1, NULL);
+		process_job_batches();
+		sceKernelSignalSema(job_done_sema, 1);
+	}
+	return 0;
+}
+
+static void init_job_workers(void) {
+	job_start_sema = sceKernelCreateSema("vitaGL Jobs Start Sema", 0, 0, JOB_WORKERS_NUM, NULL);
+	job_done_sema = sceKernelCreateSema("vitaGL Jobs Done Sema", 0, 0, JOB_WORKERS_NUM, NULL);
+	for (int i = 0; i < JOB_WORKERS_NUM; i++) {
+		job_workers[i] = sceKernelCreateThread("vitaGL Job Worker", &job_worker, SCE_KERNEL_DEFAULT_PRIORITY_USER, JOB_WORKER_STACK_SIZE, 0, SCE_KERNEL_CPU_MASK_USER_1 << i, NULL);
+		sceKernelStartThread(job_workers[i], 0, NULL);
+	}
+	job_workers_ready = GL_TRUE;
+}
+
+void vgl_init_jobs(void) {
+	sceKernelCreateLwMutex(&job_mutex, "vitaGL Jobs Mutex", 0, 0, NULL);
+}
+
+void vgl_run_jobs(job_cb cb, void *arg, uint32_t count, uint32_t grain) {
+	// Small jobs are not worth waking the workers up
+	if (count <= grain) {
+		cb(arg, 0, count);
+		return;
+	}
+
+	// Workers are busy with a job submitted by another thread (or by a callback of the current job), running this one inline
+	if (sceKernelTryLockLwMutex(&job_mutex, 1) < 0) {
+		cb(arg, 0, count);
+		return;
+	}
+
+	if (!job_workers_ready)
+		init_job_workers();
+
+	// Semaphores act as memory barriers, so job state is visible to the workers once they wake up
+	job_func = cb;
+	job_arg = arg;
+	job_count = count;
+	job_grain = grain;
+	job_next = 0;
+	sceKernelSignalSema(job_start_sema, JOB_WORKERS_NUM);
+	process_job_batches();
+	for (int i = 0; i < JOB_WORKERS_NUM; i++) {
+		sceKernelWaitSema(job_done_sema, 1, NULL);
+	}
+	sceKernelUnlockLwMutex(&job_mutex, 1);
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * job_utils.h:
+ * Header file for the worker threads utilities exposed by job_utils.c
+ */
+
+#ifndef _JOB_UTILS_H_
+#define _JOB_UTILS_H_
+
+// Callback processing the job units in the [start, end) range
+typedef void (*job_cb)(void *arg, uint32_t start, uint32_t end);
+
+// Initializes the worker threads utilities
+void vgl_init_jobs(void);
+
+// Splits count job units in batches of grain units and processes them on the worker threads and the calling one
+void vgl_run_jobs(job_cb cb, void *arg, uint32_t count, uint32_t grain);
+
+#endif
@@ -113,6 +113,10 @@ STBDDEF void stb_compress_bc5_block(unsigned char *dest, const unsigned char *sr
 #define STBD_MEMSET memset
 #endif
 
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
 static unsigned char stb__Expand5[32];
 static unsigned char stb__Expand6[64];
 static unsigned char stb__OMatch5[256][2];
@@ -222,6 +226,31 @@ static void stb__DitherBlock(unsigned char *dest, unsigned char *block) {
 	}
 }
 
+// Projects the block pixels onto a color axis
+static void stb__DotBlock(int *dots, const unsigned char *block, int vr, int vg, int vb) {
+#ifdef __ARM_NEON__
+	// Axis components never exceed 587 in magnitude, so the products can be widened from 16 bit lanes
+	uint8x16x4_t px = vld4q_u8(block);
+	int16x8_t r_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[0])));
+	int16x8_t r_hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[0])));
+	int16x8_t g_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[1])));
+	int16x8_t g_hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[1])));
+	int16x8_t b_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(px.val[2])));
+	int16x8_t b_hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(px.val[2])));
+	int16x4_t vr4 = vdup_n_s16(vr);
+	int16x4_t vg4 = vdup_n_s16(vg);
+	int16x4_t vb4 = vdup_n_s16(vb);
+	vst1q_s32(dots, vmlal_s16(vmlal_s16(vmull_s16(vget_low_s16(r_lo), vr4), vget_low_s16(g_lo), vg4), vget_low_s16(b_lo), vb4));
+	vst1q_s32(dots + 4, vmlal_s16(vmlal_s16(vmull_s16(vget_high_s16(r_lo), vr4), vget_high_s16(g_lo), vg4), vget_high_s16(b_lo), vb4));
+	vst1q_s32(dots + 8, vmlal_s16(vmlal_s16(vmull_s16(vget_low_s16(r_hi), vr4), vget_low_s16(g_hi), vg4), vget_low_s16(b_hi), vb4));
+	vst1q_s32(dots + 12, vmlal_s16(vmlal_s16(vmull_s16(vget_high_s16(r_hi), vr4), vget_high_s16(g_hi), vg4), vget_high_s16(b_hi), vb4));
+#else
+	int i;
+	for (i = 0; i < 16; i++)
+		dots[i] = block[i * 4 + 0] * vr + block[i * 4 + 1] * vg + block[i * 4 + 2] * vb;
+#endif
+}
+
 // The color matching function
 static unsigned int stb__MatchColorsBlock(unsigned char *block, unsigned char *color, int dither) {
 	unsigned int mask = 0;
@@ -233,8 +262,7 @@ static unsigned int stb__MatchColorsBlock(unsigned char *block, unsigned char *c
 	int i;
 	int c0Point, halfPoint, c3Point;
 
-	for (i = 0; i < 16; i++)
-		dots[i] = block[i * 4 + 0] * dirr + block[i * 4 + 1] * dirg + block[i * 4 + 2] * dirb;
+	stb__DotBlock(dots, block, dirr, dirg, dirb);
 
 	for (i = 0; i < 4; i++)
 		stops[i] = color[i * 4 + 0] * dirr + color[i * 4 + 1] * dirg + color[i * 4 + 2] * dirb;
@@ -406,8 +434,10 @@ static void stb__OptimizeColorsBlock(unsigned char *block, unsigned short *pmax1
 	}
 
 	// Pick colors at extreme points
+	int dots[16];
+	stb__DotBlock(dots, block, v_r, v_g, v_b);
 	for (i = 0; i < 16; i++) {
-		int dot = block[i * 4 + 0] * v_r + block[i * 4 + 1] * v_g + block[i * 4 + 2] * v_b;
+		int dot = dots[i];
 
 		if (dot < mind) {
 			mind = dot;
@@ -0,0 +1,341 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * transcode_utils.c:
+ * Utilities to transcode ETC and ATITC compressed blocks to DXT ones
+ */
+#include "../shared.h"
+
+#define TRANSCODE_JOB_BLOCKS 256 // Number of blocks transcoded by a single job batch
+
+typedef struct {
+	uint8_t *dst;
+	const uint8_t *src;
+	transcode_mode mode;
+} transcode_job;
+
+static const int etc1_modifier_table[8][4] = {
+	{2, 8, -2, -8},
+	{5, 17, -5, -17},
+	{9, 29, -9, -29},
+	{13, 42, -13, -42},
+	{18, 60, -18, -60},
+	{24, 80, -24, -80},
+	{33, 106, -33, -106},
+	{47, 183, -47, -183}
+};
+
+static inline int clamp_u8(int x) {
+	return x < 0 ? 0 : (x > 255 ? 255 : x);
+}
+
+static inline uint16_t pack_565(const int *c) {
+	return (((c[0] * 31 + 127) / 255) << 11) | (((c[1] * 63 + 127) / 255) << 5) | ((c[2] * 31 + 127) / 255);
+}
+
+static inline void unpack_565(uint16_t v, int *c) {
+	int r = v >> 11;
+	int g = (v >> 5) & 0x3F;
+	int b = v & 0x1F;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+static inline void unpack_555(uint16_t v, int *c) {
+	int r = (v >> 10) & 0x1F;
+	int g = (v >> 5) & 0x1F;
+	int b = v & 0x1F;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 3) | (g >> 2);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+static inline int color_dist(const int *a, const int *b) {
+	int dr = a[0] - b[0];
+	int dg = a[1] - b[1];
+	int db = a[2] - b[2];
+	return dr * dr + dg * dg + db * db;
+}
+
+static inline void write_color_endpoints(uint8_t *dst, uint16_t c0, uint16_t c1, uint32_t indices) {
+	uint16_t *endpoints = (uint16_t *)dst;
+	endpoints[0] = c0;
+	endpoints[1] = c1;
+	*(uint32_t *)&dst[4] = indices;
+}
+
+// Writes a DXT color block approximating a source palette, pixels are given as palette entries in (x + 4 * y) order
+// Endpoints are picked among the candidates palette entries, every used entry must be a candidate when no hint is available
+static void write_color_block(uint8_t *dst, int pal[][3], int n, const uint8_t *entries, uint32_t used, uint32_t candidates) {
+	// Picking the two most distant candidates as endpoints
+	int e0 = entries[0], e1 = entries[0], max_dist = -1;
+	for (int i = 0; i < n; i++) {
+		if (!(candidates & (1 << i)))
+			continue;
+		for (int j = i + 1; j < n; j++) {
+			if (!(candidates & (1 << j)))
+				continue;
+			int d = color_dist(pal[i], pal[j]);
+			if (d > max_dist) {
+				max_dist = d;
+				e0 = i;
+				e1 = j;
+			}
+		}
+	}
+	uint16_t c0 = pack_565(pal[e0]);
+	uint16_t c1 = pack_565(pal[e1]);
+	if (c0 < c1) {
+		uint16_t tmp = c0;
+		c0 = c1;
+		c1 = tmp;
+	}
+
+	// Mapping every used palette color to the closest DXT one in four colors mode by projecting it on the endpoints line,
+	// matching endpoints result in a flat block
+	uint32_t indices = 0;
+	if (c0 != c1) {
+		static const uint8_t line_order[4] = {0, 2, 3, 1};
+		int dxt0[3], dxt1[3], axis[3];
+		uint8_t map[16];
+		unpack_565(c0, dxt0);
+		unpack_565(c1, dxt1);
+		for (int k = 0; k < 3; k++) {
+			axis[k] = dxt1[k] - dxt0[k];
+		}
+		int len = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		for (int i = 0; i < n; i++) {
+			if (!(used & (1 << i)))
+				continue;
+			int dot = (pal[i][0] - dxt0[0]) * axis[0] + (pal[i][1] - dxt0[1]) * axis[1] + (pal[i][2] - dxt0[2]) * axis[2];
+			int step = (6 * dot > len) + (6 * dot > 3 * len) + (6 * dot > 5 * len);
+			map[i] = line_order[step];
+		}
+		for (int p = 0; p < 16; p++) {
+			indices |= map[entries[p]] << (p * 2);
+		}
+	}
+	write_color_endpoints(dst, c0, c1, indices);
+}
+
+// Transcodes an ETC1 block or the color part of an ETC2 block to a DXT color block
+static void transcode_etc_color_block(uint8_t *dst, const uint8_t *src) {
+	int pal[16][3];
+	uint8_t entries[16];
+
+	// Individual and differential blocks hold two subblocks with four colors each
+	int base[2][3];
+	GLboolean has_subblocks = GL_TRUE;
+	if (src[3] & 2) {
+		for (int k = 0; k < 3; k++) {
+			int c = src[k] >> 3;
+			int d = c + ((src[k] & 7) ^ 4) - 4;
+			if (d < 0 || d > 31) {
+				// Overflowing differential colors flag ETC2 T, H and planar blocks
+				has_subblocks = GL_FALSE;
+				break;
+			}
+			base[0][k] = (c << 3) | (c >> 2);
+			base[1][k] = (d << 3) | (d >> 2);
+		}
+	} else {
+		for (int k = 0; k < 3; k++) {
+			base[0][k] = (src[k] >> 4) * 0x11;
+			base[1][k] = (src[k] & 0x0F) * 0x11;
+		}
+	}
+
+	if (has_subblocks) {
+		const int *table[2] = {etc1_modifier_table[src[3] >> 5], etc1_modifier_table[(src[3] >> 2) & 7]};
+		for (int s = 0; s < 2; s++) {
+			for (int i = 0; i < 4; i++) {
+				for (int k = 0; k < 3; k++) {
+					pal[s * 4 + i][k] = clamp_u8(base[s][k] + table[s][i]);
+				}
+			}
+		}
+		uint32_t bits = (src[4] << 24) | (src[5] << 16) | (src[6] << 8) | src[7];
+		int flipped = src[3] & 1;
+		uint32_t used = 0;
+		for (int p = 0; p < 16; p++) {
+			int x = p & 3;
+			int y = p >> 2;
+			int k = y + x * 4;
+			int second = flipped ? (y >> 1) : (x >> 1);
+			entries[p] = (second << 2) | ((bits >> k) & 1) | ((bits >> (k + 15)) & 2);
+			used |= 1 << entries[p];
+		}
+
+		// Subblock colors lie on a line sorted by modifier, so only the lowest and highest used ones can be endpoints
+		static const uint8_t modifier_order[4] = {3, 2, 0, 1};
+		uint32_t candidates = 0;
+		for (int s = 0; s < 2; s++) {
+			int lowest = -1, highest = -1;
+			for (int i = 0; i < 4; i++) {
+				int entry = s * 4 + modifier_order[i];
+				if (used & (1 << entry)) {
+					if (lowest < 0)
+						lowest = entry;
+					highest = entry;
+				}
+			}
+			if (lowest >= 0)
+				candidates |= (1 << lowest) | (1 << highest);
+		}
+		write_color_block(dst, pal, 8, entries, used, candidates);
+	} else {
+		// Rare ETC2 modes are decoded and fitted per pixel
+		uint8_t pixels[16 * 4];
+		detexDecompressBlockETC2(src, DETEX_MODE_MASK_ALL, 0, pixels);
+		for (int p = 0; p < 16; p++) {
+			pal[p][0] = pixels[p * 4];
+			pal[p][1] = pixels[p * 4 + 1];
+			pal[p][2] = pixels[p * 4 + 2];
+			entries[p] = p;
+		}
+		write_color_block(dst, pal, 16, entries, 0xFFFF, 0xFFFF);
+	}
+}
+
+// Transcodes an ETC2 EAC alpha block to a DXT5 alpha block
+static void transcode_eac_alpha_block(uint8_t *dst, const uint8_t *src) {
+	const int8_t *table = eac_modifier_table[src[1] & 0x0F];
+	int multiplier = src[1] >> 4;
+	uint64_t bits = ((uint64_t)src[2] << 40) | ((uint64_t)src[3] << 32) | ((uint64_t)src[4] << 24) | ((uint64_t)src[5] << 16) | ((uint64_t)src[6] << 8) | src[7];
+
+	int pal[8];
+	for (int i = 0; i < 8; i++) {
+		pal[i] = clamp_u8(src[0] + table[i] * multiplier);
+	}
+
+	// EAC pixels are stored in columns order
+	uint8_t entries[16];
+	int a0 = 0, a1 = 255;
+	for (int p = 0; p < 16; p++) {
+		int i = (p & 3) * 4 + (p >> 2);
+		entries[p] = (bits >> (45 - i * 3)) & 7;
+		int a = pal[entries[p]];
+		if (a > a0)
+			a0 = a;
+		if (a < a1)
+			a1 = a;
+	}
+
+	// Mapping every EAC alpha value to the closest DXT5 one in eight alphas mode
+	uint64_t indices = 0;
+	if (a0 != a1) {
+		int dxt[8];
+		uint8_t map[8];
+		dxt[0] = a0;
+		dxt[1] = a1;
+		for (int i = 2; i < 8; i++) {
+			dxt[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+		}
+		for (int i = 0; i < 8; i++) {
+			int best = 256;
+			for (int m = 0; m < 8; m++) {
+				int d = abs(pal[i] - dxt[m]);
+				if (d < best) {
+					best = d;
+					map[i] = m;
+				}
+			}
+		}
+		for (int p = 0; p < 16; p++) {
+			indices |= (uint64_t)map[entries[p]] << (p * 3);
+		}
+	}
+	dst[0] = a0;
+	dst[1] = a1;
+	for (int i = 0; i < 6; i++) {
+		dst[2 + i] = (indices >> (i * 8)) & 0xFF;
+	}
+}
+
+// Transcodes an ATITC color block to a DXT color block
+static void transcode_atc_color_block(uint8_t *dst, const uint8_t *src) {
+	uint16_t a0 = src[0] | (src[1] << 8);
+	uint16_t a1 = src[2] | (src[3] << 8);
+	uint32_t bits = src[4] | (src[5] << 8) | (src[6] << 16) | (src[7] << 24);
+
+	if (!(a0 & 0x8000)) {
+		// Four colors ATITC blocks only differ from DXT ones in color0 encoding and in the interpolated colors indices
+		static const uint8_t map[2][4] = {
+			{0, 2, 3, 1},
+			{1, 3, 2, 0}
+		};
+		int g = (a0 >> 5) & 0x1F;
+		uint16_t e0 = ((a0 & 0x7C00) << 1) | (((g << 1) | (g >> 4)) << 5) | (a0 & 0x1F);
+		int swapped = e0 < a1;
+		uint16_t c0 = swapped ? a1 : e0;
+		uint16_t c1 = swapped ? e0 : a1;
+		uint32_t indices = 0;
+		if (c0 != c1) {
+			for (int p = 0; p < 16; p++) {
+				indices |= map[swapped][(bits >> (p * 2)) & 3] << (p * 2);
+			}
+		}
+		write_color_endpoints(dst, c0, c1, indices);
+	} else {
+		// Three colors ATITC blocks hold black and a color extrapolated from the endpoints
+		int pal[4][3];
+		uint8_t entries[16];
+		unpack_555(a0, pal[2]);
+		unpack_565(a1, pal[3]);
+		for (int k = 0; k < 3; k++) {
+			pal[0][k] = 0;
+			pal[1][k] = clamp_u8(pal[2][k] - pal[3][k] / 4);
+		}
+		uint32_t used = 0;
+		for (int p = 0; p < 16; p++) {
+			entries[p] = (bits >> (p * 2)) & 3;
+			used |= 1 << entries[p];
+		}
+		write_color_block(dst, pal, 4, entries, used, used);
+	}
+}
+
+static void transcode_blocks(void *arg, uint32_t start, uint32_t end) {
+	transcode_job *job = (transcode_job *)arg;
+	for (uint32_t i = start; i < end; i++) {
+		switch (job->mode) {
+		case TRANSCODE_ETC1_TO_DXT1:
+			transcode_etc_color_block(&job->dst[i * 8], &job->src[i * 8]);
+			break;
+		case TRANSCODE_ETC2_EAC_TO_DXT5:
+			transcode_eac_alpha_block(&job->dst[i * 16], &job->src[i * 16]);
+			transcode_etc_color_block(&job->dst[i * 16 + 8], &job->src[i * 16 + 8]);
+			break;
+		case TRANSCODE_ATC_RGB_TO_DXT1:
+			transcode_atc_color_block(&job->dst[i * 8], &job->src[i * 8]);
+			break;
+		default:
+			// ATITC alpha blocks share the same layout of DXT3 and DXT5 ones
+			sceClibMemcpy(&job->dst[i * 16], &job->src[i * 16], 8);
+			transcode_atc_color_block(&job->dst[i * 16 + 8], &job->src[i * 16 + 8]);
+			break;
+		}
+	}
+}
+
+void transcode_to_dxt(uint8_t *dst, const uint8_t *src, int w, int h, transcode_mode mode) {
+	transcode_job job = {dst, src, mode};
+	vgl_run_jobs(transcode_blocks, &job, ((w + 3) / 4) * ((h + 3) / 4), TRANSCODE_JOB_BLOCKS);
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of vitaGL
+ * Copyright 2017, 2018, 2019, 2020 Rinnegatamante
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * transcode_utils.h:
+ * Header file for the compressed textures transcoding utilities exposed by transcode_utils.c
+ */
+
+#ifndef _TRANSCODE_UTILS_H_
+#define _TRANSCODE_UTILS_H_
+
+typedef enum {
+	TRANSCODE_ETC1_TO_DXT1,
+	TRANSCODE_ETC2_EAC_TO_DXT5,
+	TRANSCODE_ATC_RGB_TO_DXT1,
+	TRANSCODE_ATC_EXPLICIT_ALPHA_TO_DXT3,
+	TRANSCODE_ATC_INTERPOLATED_ALPHA_TO_DXT5
+} transcode_mode;
+
+// Transcodes compressed blocks straight to DXT blocks of the same size, output blocks are kept in the same linear order
+void transcode_to_dxt(uint8_t *dst, const uint8_t *src, int w, int h, transcode_mode mode);
+
+#endif
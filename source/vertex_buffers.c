@@ -25,8 +25,13 @@
 
 #define DISABLED_ATTRIBS_POOL_SIZE (256 * 1024) // Disabled attributes circular pool size in bytes for the default VAO
 #define DISABLED_AUX_ATTRIBS_POOL_SIZE (64 * 1024) // Disabled attributes circular pool size in bytes for non default VAOs
+#define BUFFER_VERSIONS_NUM FRAME_PURGE_FREQ // Maximum number of retired versions kept per buffer for orphaning
+#define BUFFER_VERSIONS_IDLE_FRAMES 60 // Number of frames after which a retired buffer version not recycled anymore gets freed
+#define CLIENT_ARRAYS_CACHE_SIZE 256 // Number of entries in the client vertex arrays cache
+#define CLIENT_ARRAYS_CACHE_MIN_SIZE 512 // Minimum size in bytes for a client vertex array to be cached
 
 uint32_t vertex_array_unit = 0; // Current in-use vertex array buffer unit
+uint32_t pixel_unpack_unit = 0; // Current in-use pixel unpack buffer unit
 
 void *vertex_object; // Vertex object address for vgl* draw pipeline
 void *color_object; // Color object address for vgl* draw pipeline
@@ -36,6 +41,244 @@ void *index_object; // Index object address for vgl* draw pipeline
 static vao default_vao; // Vertex Array Object used when no vao is bound
 vao *cur_vao = &default_vao; // Current in-use vertex array object
 
+// Retired buffer version struct
+typedef struct {
+	void *ptr; // Retired buffer content
+	uint32_t last_frame; // Frame number of the last draw call reading this version
+	uint32_t dirty_start; // Start of the range modified since this version got retired
+	uint32_t dirty_end; // End of the range modified since this version got retired
+} buffer_version;
+
+// A buffer version can be written only once every frame that read it has been completed by the GPU
+#define isVersionInFlight(used, frame) (used && frame_counter - (frame) < FRAME_PURGE_FREQ)
+
+// Buffers in use by the GPU need orphaning before being written unless the application handles synchronization itself
+#define needsOrphaning(x) (!isBufferPersistent(x) && isVersionInFlight(x->used, x->last_frame))
+
+static gpubuffer *versioned_buffers = NULL; // List of buffers holding retired versions
+
+static inline void release_buffer_content(void *ptr, GLboolean in_flight) {
+	if (in_flight)
+		markAsDirty(ptr);
+	else
+		vglFree(ptr);
+}
+
+// Frees the retired versions array of a buffer and unlinks the buffer from the versioned buffers list
+static void free_buffer_versions(gpubuffer *gpu_buf) {
+	gpubuffer *prev = NULL;
+	gpubuffer *cur = versioned_buffers;
+	while (cur != gpu_buf) {
+		prev = cur;
+		cur = (gpubuffer *)cur->versions_next;
+	}
+	if (prev)
+		prev->versions_next = gpu_buf->versions_next;
+	else
+		versioned_buffers = (gpubuffer *)gpu_buf->versions_next;
+	gpu_buf->versions_next = NULL;
+	vglFree(gpu_buf->versions);
+	gpu_buf->versions = NULL;
+}
+
+// Releases the current content of a buffer together with all its retired versions
+static void release_buffer(gpubuffer *gpu_buf) {
+	if (gpu_buf->ptr) {
+		release_buffer_content(gpu_buf->ptr, isVersionInFlight(gpu_buf->used, gpu_buf->last_frame));
+		gpu_buf->ptr = NULL;
+	}
+	if (gpu_buf->versions) {
+		buffer_version *v = (buffer_version *)gpu_buf->versions;
+		for (int i = 0; i < BUFFER_VERSIONS_NUM; i++) {
+			if (v[i].ptr)
+				release_buffer_content(v[i].ptr, isVersionInFlight(GL_TRUE, v[i].last_frame));
+		}
+		free_buffer_versions(gpu_buf);
+	}
+}
+
+void purgeIdleBufferVersions(void) {
+	gpubuffer *gpu_buf = versioned_buffers;
+	while (gpu_buf) {
+		gpubuffer *next = (gpubuffer *)gpu_buf->versions_next;
+		buffer_version *v = (buffer_version *)gpu_buf->versions;
+		GLboolean empty = GL_TRUE;
+		for (int i = 0; i < BUFFER_VERSIONS_NUM; i++) {
+			if (v[i].ptr) {
+				// Versions idle for this long are way past their last GPU read, so they can be freed right away
+				if (frame_counter - v[i].last_frame >= BUFFER_VERSIONS_IDLE_FRAMES) {
+					vglFree(v[i].ptr);
+					v[i].ptr = NULL;
+				} else
+					empty = GL_FALSE;
+			}
+		}
+		if (empty)
+			free_buffer_versions(gpu_buf);
+		gpu_buf = next;
+	}
+}
+
+// Flags a range of the current buffer content as modified for all retired versions
+static void add_buffer_dirty_range(gpubuffer *gpu_buf, uint32_t start, uint32_t end) {
+	if (!gpu_buf->versions)
+		return;
+	buffer_version *v = (buffer_version *)gpu_buf->versions;
+	for (int i = 0; i < BUFFER_VERSIONS_NUM; i++) {
+		if (v[i].ptr) {
+			v[i].dirty_start = min(v[i].dirty_start, start);
+			v[i].dirty_end = max(v[i].dirty_end, end);
+		}
+	}
+}
+
+// Copies a buffer range skipping a sub range which is going to be overwritten
+static void copy_buffer_range(uint8_t *dst, uint8_t *src, uint32_t start, uint32_t end, uint32_t skip_start, uint32_t skip_end) {
+	if (start >= end)
+		return;
+	if (skip_start > start)
+		vgl_memcpy(dst + start, src + start, min(end, skip_start) - start);
+	if (skip_end < end) {
+		uint32_t s = max(start, skip_end);
+		vgl_memcpy(dst + s, src + s, end - s);
+	}
+}
+
+/*
+ * Replaces the in-flight content of a buffer with a writable version holding the same data except for
+ * the [skip_start, skip_end) range that the caller is going to overwrite. Retired versions are recycled
+ * copying only the ranges modified since their retirement, a new version is allocated otherwise.
+ */
+static GLboolean orphan_buffer(gpubuffer *gpu_buf, uint32_t skip_start, uint32_t skip_end) {
+	if (!gpu_buf->versions) {
+		gpu_buf->versions = vglCalloc(BUFFER_VERSIONS_NUM, sizeof(buffer_version));
+		if (!gpu_buf->versions)
+			return GL_FALSE;
+		gpu_buf->versions_next = versioned_buffers;
+		versioned_buffers = gpu_buf;
+	}
+	buffer_version *v = (buffer_version *)gpu_buf->versions;
+
+	// Searching for a retired version completed by the GPU, an empty slot or the oldest version
+	int free_slot = -1, empty_slot = -1, oldest_slot = 0;
+	for (int i = 0; i < BUFFER_VERSIONS_NUM; i++) {
+		if (!v[i].ptr) {
+			if (empty_slot < 0)
+				empty_slot = i;
+		} else if (!isVersionInFlight(GL_TRUE, v[i].last_frame)) {
+			free_slot = i;
+			break;
+		} else if (frame_counter - v[i].last_frame > frame_counter - v[oldest_slot].last_frame)
+			oldest_slot = i;
+	}
+
+	uint8_t *ptr;
+	int slot;
+	if (free_slot >= 0) {
+		slot = free_slot;
+		ptr = (uint8_t *)v[slot].ptr;
+		copy_buffer_range(ptr, (uint8_t *)gpu_buf->ptr, v[slot].dirty_start, v[slot].dirty_end, skip_start, skip_end);
+	} else {
+		ptr = (uint8_t *)gpu_alloc_mapped(gpu_buf->size, gpu_buf->type);
+		if (!ptr)
+			return GL_FALSE;
+		copy_buffer_range(ptr, (uint8_t *)gpu_buf->ptr, 0, gpu_buf->size, skip_start, skip_end);
+		if (empty_slot >= 0)
+			slot = empty_slot;
+		else {
+			slot = oldest_slot;
+			markAsDirty(v[slot].ptr);
+		}
+	}
+
+	// Retiring the in-flight content
+	v[slot].ptr = gpu_buf->ptr;
+	v[slot].last_frame = gpu_buf->last_frame;
+	v[slot].dirty_start = gpu_buf->size;
+	v[slot].dirty_end = 0;
+	add_buffer_dirty_range(gpu_buf, skip_start, skip_end);
+
+	gpu_buf->ptr = ptr;
+	gpu_buf->used = GL_FALSE;
+	return GL_TRUE;
+}
+
+// Client vertex arrays cache entry
+typedef struct {
+	const void *src; // Client vertex array address
+	uint32_t size; // Client vertex array size in bytes
+	uint32_t hash; // Client vertex array content hash
+	void *ptr; // GPU copy of the client vertex array
+} client_array;
+
+static client_array client_arrays_cache[CLIENT_ARRAYS_CACHE_SIZE]; // Client vertex arrays cache
+static uint32_t client_arrays_cache_budget = 0; // Max amount of bytes hashed per frame by client vertex arrays cache (0 = disabled)
+static uint32_t client_arrays_cache_frame_bytes = 0; // Amount of bytes hashed in current frame by client vertex arrays cache
+
+#define HASH_PRIME1 0x9E3779B1
+#define HASH_PRIME2 0x85EBCA77
+#define HASH_PRIME3 0xC2B2AE3D
+#define hash_round(h, v) h = (((h + (v) * HASH_PRIME2) << 13) | ((h + (v) * HASH_PRIME2) >> 19)) * HASH_PRIME1
+#define hash_rotl(h, n) ((h << n) | (h >> (32 - n)))
+
+// Hashes a 4 bytes aligned memory block with four independent lanes (xxHash32 layout)
+static uint32_t hash_client_array(const uint32_t *data, uint32_t size) {
+	uint32_t h0 = HASH_PRIME1 + HASH_PRIME2;
+	uint32_t h1 = HASH_PRIME2;
+	uint32_t h2 = 0;
+	uint32_t h3 = -HASH_PRIME1;
+	uint32_t n = size / 16;
+	for (uint32_t i = 0; i < n; i++) {
+		hash_round(h0, data[0]);
+		hash_round(h1, data[1]);
+		hash_round(h2, data[2]);
+		hash_round(h3, data[3]);
+		data += 4;
+	}
+	uint32_t h = hash_rotl(h0, 1) + hash_rotl(h1, 7) + hash_rotl(h2, 12) + hash_rotl(h3, 18) + size;
+	uint8_t *tail = (uint8_t *)data;
+	for (uint32_t i = 0; i < (size & 15); i++) {
+		h = (h ^ tail[i]) * HASH_PRIME1;
+	}
+	h ^= h >> 15;
+	h *= HASH_PRIME2;
+	h ^= h >> 13;
+	h *= HASH_PRIME3;
+	h ^= h >> 16;
+	return h;
+}
+
+void *upload_client_array(const void *src, uint32_t size) {
+	// Small, unaligned or over budget arrays are just copied in temporary memory
+	if (size >= CLIENT_ARRAYS_CACHE_MIN_SIZE && !((uint32_t)src & 3) && client_arrays_cache_frame_bytes + size <= client_arrays_cache_budget) {
+		client_arrays_cache_frame_bytes += size;
+		uint32_t hash = hash_client_array((const uint32_t *)src, size);
+		client_array *e = &client_arrays_cache[(((uint32_t)src >> 4) ^ size) % CLIENT_ARRAYS_CACHE_SIZE];
+		if (e->src == src && e->size == size && e->hash == hash)
+			return e->ptr;
+
+		// Replacing the entry content, previous copy may still be in use by the GPU
+		void *ptr = gpu_alloc_mapped(size, use_vram ? VGL_MEM_VRAM : VGL_MEM_RAM);
+		if (ptr) {
+			if (e->ptr)
+				markAsDirty(e->ptr);
+			e->src = src;
+			e->size = size;
+			e->hash = hash;
+			e->ptr = ptr;
+			vgl_fast_memcpy(ptr, src, size);
+			return ptr;
+		}
+	}
+	void *ptr = gpu_alloc_mapped_temp(size);
+	vgl_fast_memcpy(ptr, src, size);
+	return ptr;
+}
+
+void resetClientArraysCacheBudget(void) {
+	client_arrays_cache_frame_bytes = 0;
+}
+
 void resetVao(vao *v) {
 	sceClibMemset(v->vertex_attrib_offsets, 0, sizeof(uint32_t) * VERTEX_ATTRIBS_NUM);
 	sceClibMemset(v->vertex_attrib_vbo, 0, sizeof(uint32_t) * VERTEX_ATTRIBS_NUM);
@@ -141,6 +384,9 @@ void glBindBuffer(GLenum target, GLuint buffer) {
 	case GL_ELEMENT_ARRAY_BUFFER:
 		cur_vao->index_array_unit = buffer;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		pixel_unpack_unit = buffer;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
 	}
@@ -157,12 +403,10 @@ void glDeleteBuffers(GLsizei n, const GLuint *gl_buffers) {
 	for (j = 0; j < n; j++) {
 		if (gl_buffers[j]) {
 			gpubuffer *gpu_buf = (gpubuffer *)gl_buffers[j];
-			if (gpu_buf->ptr) {
-				if (gpu_buf->used)
-					markAsDirty(gpu_buf->ptr);
-				else
-					vglFree(gpu_buf->ptr);
-			}
+			if (gl_buffers[j] == pixel_unpack_unit)
+				pixel_unpack_unit = 0;
+			purgeIndicesCache(gpu_buf);
+			release_buffer(gpu_buf);
 			vglFree(gpu_buf);
 		}
 	}
@@ -177,36 +421,98 @@ void glBufferData(GLenum target, GLsizei size, const GLvoid *data, GLenum usage)
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
 	}
 #ifndef SKIP_ERROR_HANDLING
 	if (size < 0) {
 		SET_GL_ERROR(GL_INVALID_VALUE)
-	} else if (!gpu_buf) {
+	} else if (!gpu_buf || gpu_buf->immutable) {
 		SET_GL_ERROR(GL_INVALID_OPERATION)
 	}
 #endif
+	vglMemType type;
 	switch (usage) {
 	case GL_DYNAMIC_DRAW:
 	case GL_DYNAMIC_READ:
 	case GL_DYNAMIC_COPY:
-		gpu_buf->type = VGL_MEM_RAM;
+		type = VGL_MEM_RAM;
 		break;
 	default:
-		gpu_buf->type = VGL_MEM_VRAM;
+		type = VGL_MEM_VRAM;
 		break;
 	}
+	purgeIndicesCache(gpu_buf);
 
-	// Marking previous content for deletion or deleting it straight if unused
-	if (gpu_buf->ptr) {
-		if (gpu_buf->used)
-			markAsDirty(gpu_buf->ptr);
-		else
-			vglFree(gpu_buf->ptr);
+	if (gpu_buf->ptr && gpu_buf->size == size && gpu_buf->type == type) {
+		// Reusing current storage if the GPU is done with it, or orphaning it otherwise
+		if (!isVersionInFlight(gpu_buf->used, gpu_buf->last_frame) || orphan_buffer(gpu_buf, 0, size)) {
+			gpu_buf->used = GL_FALSE;
+			if (data)
+				vgl_fast_memcpy(gpu_buf->ptr, data, size);
+			add_buffer_dirty_range(gpu_buf, 0, size);
+			return;
+		}
 	}
 
+	// Marking previous content for deletion or deleting it straight if unused
+	release_buffer(gpu_buf);
+
 	// Allocating a new buffer
+	gpu_buf->type = type;
+	gpu_buf->ptr = gpu_alloc_mapped(size, gpu_buf->type);
+
+#ifndef SKIP_ERROR_HANDLING
+	if (!gpu_buf->ptr) {
+		SET_GL_ERROR(GL_OUT_OF_MEMORY)
+	}
+#endif
+
+	gpu_buf->size = size;
+	gpu_buf->used = GL_FALSE;
+
+	if (data)
+		vgl_fast_memcpy(gpu_buf->ptr, data, size);
+}
+
+void glBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {
+	gpubuffer *gpu_buf;
+	switch (target) {
+	case GL_ARRAY_BUFFER:
+		gpu_buf = (gpubuffer *)vertex_array_unit;
+		break;
+	case GL_ELEMENT_ARRAY_BUFFER:
+		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
+		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
+	default:
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
+	}
+#ifndef SKIP_ERROR_HANDLING
+	if (size <= 0) {
+		SET_GL_ERROR(GL_INVALID_VALUE)
+	} else if (flags & ~(GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_DYNAMIC_STORAGE_BIT | GL_CLIENT_STORAGE_BIT)) {
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_VALUE, flags)
+	} else if ((flags & GL_MAP_PERSISTENT_BIT) && !(flags & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))) {
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_VALUE, flags)
+	} else if ((flags & GL_MAP_COHERENT_BIT) && !(flags & GL_MAP_PERSISTENT_BIT)) {
+		SET_GL_ERROR_WITH_VALUE(GL_INVALID_VALUE, flags)
+	} else if (!gpu_buf || gpu_buf->immutable) {
+		SET_GL_ERROR(GL_INVALID_OPERATION)
+	}
+#endif
+
+	// Marking previous content for deletion or deleting it straight if unused
+	purgeIndicesCache(gpu_buf);
+	release_buffer(gpu_buf);
+
+	// Storages read back by the CPU or flagged as client storage are placed in RAM
+	gpu_buf->type = (flags & (GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT)) ? VGL_MEM_RAM : VGL_MEM_VRAM;
 	gpu_buf->ptr = gpu_alloc_mapped(size, gpu_buf->type);
 
 #ifndef SKIP_ERROR_HANDLING
@@ -215,8 +521,14 @@ void glBufferData(GLenum target, GLsizei size, const GLvoid *data, GLenum usage)
 	}
 #endif
 
+	/*
+	 * Buffers memory is mapped for both CPU and GPU, so every persistent mapping is coherent: the storage address
+	 * never changes during the buffer lifetime and synchronization is up to the application (eg. through fences).
+	 */
 	gpu_buf->size = size;
 	gpu_buf->used = GL_FALSE;
+	gpu_buf->storage_flags = flags;
+	gpu_buf->immutable = GL_TRUE;
 
 	if (data)
 		vgl_fast_memcpy(gpu_buf->ptr, data, size);
@@ -231,43 +543,32 @@ void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
 	}
 #ifndef SKIP_ERROR_HANDLING
-	if (!gpu_buf) {
+	if (!gpu_buf || (gpu_buf->immutable && !(gpu_buf->storage_flags & GL_DYNAMIC_STORAGE_BIT))) {
 		SET_GL_ERROR(GL_INVALID_OPERATION)
 	} else if (size < 0 || offset < 0 || offset + size > gpu_buf->size) {
 		SET_GL_ERROR(GL_INVALID_VALUE)
 	}
 #endif
+	invalidateIndicesRange(gpu_buf, offset, size);
 
-	// Allocating a new buffer
-	if (gpu_buf->used) {
-		uint8_t *ptr = gpu_alloc_mapped(gpu_buf->size, gpu_buf->type);
-
+	// Orphaning buffer content if it's still in use by the GPU
+	if (needsOrphaning(gpu_buf)) {
+		if (!orphan_buffer(gpu_buf, offset, offset + size)) {
 #ifdef LOG_ERRORS
-		if (!ptr) {
 			vgl_log("%s:%d glBufferSubData failed to alloc a buffer of %ld bytes. Buffer content won't be updated.\n", __FILE__, __LINE__, gpu_buf->size);
+#endif
 			return;
 		}
-#endif
-		
-		// Copying up previous data combined to modified data
-		if (offset > 0)
-			vgl_memcpy(ptr, gpu_buf->ptr, offset);
-		vgl_memcpy(ptr + offset, data, size);
-		if (gpu_buf->size - size - offset > 0)
-			vgl_memcpy(ptr + offset + size, (uint8_t *)gpu_buf->ptr + offset + size, gpu_buf->size - size - offset);
-
-		// Marking previous content for deletion
-		markAsDirty(gpu_buf->ptr);
-		
-		gpu_buf->ptr = ptr;
-		gpu_buf->used = GL_FALSE;
-	} else {
-		vgl_memcpy((uint8_t *)gpu_buf->ptr + offset, data, size);
-	}	
+	} else
+		add_buffer_dirty_range(gpu_buf, offset, offset + size);
+	vgl_memcpy((uint8_t *)gpu_buf->ptr + offset, data, size);
 }
 
 void *glMapBuffer(GLenum target, GLenum access) {
@@ -279,6 +580,9 @@ void *glMapBuffer(GLenum target, GLenum access) {
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, NULL)
 	}
@@ -295,10 +599,21 @@ void *glMapBuffer(GLenum target, GLenum access) {
 	
 	if (!gpu_buf || gpu_buf->mapped) {
 		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
+	} else if (gpu_buf->immutable && ((access != GL_WRITE_ONLY && !(gpu_buf->storage_flags & GL_MAP_READ_BIT)) || (access != GL_READ_ONLY && !(gpu_buf->storage_flags & GL_MAP_WRITE_BIT)))) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
 	}
 #endif
 
-	// TODO: Current implementation doesn't take into account 'used' state
+	// Orphaning buffer content if it's still in use by the GPU and we're going to write on it
+	if (access != GL_READ_ONLY && needsOrphaning(gpu_buf)) {
+		if (!orphan_buffer(gpu_buf, 0, 0)) {
+			SET_GL_ERROR_WITH_RET(GL_OUT_OF_MEMORY, NULL)
+		}
+	}
+
+	gpu_buf->map_access = access == GL_READ_ONLY ? GL_MAP_READ_BIT : GL_MAP_WRITE_BIT;
+	gpu_buf->map_offset = 0;
+	gpu_buf->map_length = gpu_buf->size;
 	gpu_buf->mapped = GL_TRUE;
 	return gpu_buf->ptr;
 }
@@ -312,6 +627,9 @@ void *glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitf
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, NULL)
 	}
@@ -319,12 +637,43 @@ void *glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitf
 #ifndef SKIP_ERROR_HANDLING
 	if (!gpu_buf || gpu_buf->mapped) {
 		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
-	} else if (offset < 0 || length < 0 || offset + length > gpu_buf->size) {
+	} else if (offset < 0 || length <= 0 || offset + length > gpu_buf->size) {
 		SET_GL_ERROR_WITH_RET(GL_INVALID_VALUE, NULL)
+	} else if (access & ~(GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_VALUE, NULL)
+	} else if (!(access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT))) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
+	} else if ((access & GL_MAP_READ_BIT) && (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT))) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
+	} else if ((access & GL_MAP_FLUSH_EXPLICIT_BIT) && !(access & GL_MAP_WRITE_BIT)) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
+	} else if ((access & (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)) && !gpu_buf->immutable) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
+	} else if (gpu_buf->immutable && (access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)) & ~gpu_buf->storage_flags) {
+		SET_GL_ERROR_WITH_RET(GL_INVALID_OPERATION, NULL)
 	}
 #endif
-	
-	// TODO: Current implementation doesn't take into account 'used' state
+
+	/*
+	 * Unsynchronized mappings return the current storage straight, leaving synchronization up to the application.
+	 * Otherwise, written buffers still in use by the GPU get orphaned, skipping the copy of invalidated ranges.
+	 */
+	if ((access & GL_MAP_WRITE_BIT) && !(access & GL_MAP_UNSYNCHRONIZED_BIT) && needsOrphaning(gpu_buf)) {
+		GLboolean res;
+		if (access & GL_MAP_INVALIDATE_BUFFER_BIT)
+			res = orphan_buffer(gpu_buf, 0, gpu_buf->size);
+		else if (access & GL_MAP_INVALIDATE_RANGE_BIT)
+			res = orphan_buffer(gpu_buf, offset, offset + length);
+		else
+			res = orphan_buffer(gpu_buf, 0, 0);
+		if (!res) {
+			SET_GL_ERROR_WITH_RET(GL_OUT_OF_MEMORY, NULL)
+		}
+	}
+
+	gpu_buf->map_access = access;
+	gpu_buf->map_offset = offset;
+	gpu_buf->map_length = length;
 	gpu_buf->mapped = GL_TRUE;
 	return (void *)((uint8_t *)gpu_buf->ptr + offset);
 }
@@ -338,6 +687,9 @@ GLboolean glUnmapBuffer(GLenum target) {
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_RET(GL_INVALID_ENUM, GL_TRUE)
 	}
@@ -348,7 +700,11 @@ GLboolean glUnmapBuffer(GLenum target) {
 	}
 #endif
 	
-	gpu_buf->used = GL_FALSE;
+	// Flagging written range as modified unless the application flushed it explicitly
+	if ((gpu_buf->map_access & (GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT)) == GL_MAP_WRITE_BIT) {
+		purgeIndicesCache(gpu_buf);
+		add_buffer_dirty_range(gpu_buf, gpu_buf->map_offset, gpu_buf->map_offset + gpu_buf->map_length);
+	}
 	gpu_buf->mapped = GL_FALSE;
 	return GL_TRUE;
 }
@@ -362,17 +718,24 @@ void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length)
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
 	}
 
 #ifndef SKIP_ERROR_HANDLING
-	if (!gpu_buf || !gpu_buf->mapped) {
+	if (!gpu_buf || !gpu_buf->mapped || !(gpu_buf->map_access & GL_MAP_FLUSH_EXPLICIT_BIT)) {
 		SET_GL_ERROR(GL_INVALID_OPERATION)
-	} else if (offset < 0 || length < 0 || offset + length > gpu_buf->size) {
+	} else if (offset < 0 || length < 0 || offset + length > gpu_buf->map_length) {
 		SET_GL_ERROR(GL_INVALID_VALUE)
 	}
 #endif
+
+	// Offset is relative to the mapped range
+	purgeIndicesCache(gpu_buf);
+	add_buffer_dirty_range(gpu_buf, gpu_buf->map_offset + offset, gpu_buf->map_offset + offset + length);
 }
 
 void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
@@ -384,6 +747,9 @@ void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
 	case GL_ELEMENT_ARRAY_BUFFER:
 		gpu_buf = (gpubuffer *)cur_vao->index_array_unit;
 		break;
+	case GL_PIXEL_UNPACK_BUFFER:
+		gpu_buf = (gpubuffer *)pixel_unpack_unit;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, target)
 	}
@@ -397,11 +763,30 @@ void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params) {
 	case GL_BUFFER_SIZE:
 		*params = gpu_buf->size;
 		break;
+	case GL_BUFFER_IMMUTABLE_STORAGE:
+		*params = gpu_buf->immutable;
+		break;
+	case GL_BUFFER_STORAGE_FLAGS:
+		*params = gpu_buf->storage_flags;
+		break;
 	default:
 		SET_GL_ERROR_WITH_VALUE(GL_INVALID_ENUM, pname)
 	}
 }
 
+void vglSetClientArraysCacheBudget(uint32_t size) {
+	client_arrays_cache_budget = size;
+
+	// Releasing cached copies when the cache gets disabled
+	if (!size) {
+		for (int i = 0; i < CLIENT_ARRAYS_CACHE_SIZE; i++) {
+			if (client_arrays_cache[i].ptr)
+				markAsDirty(client_arrays_cache[i].ptr);
+		}
+		sceClibMemset(client_arrays_cache, 0, sizeof(client_array) * CLIENT_ARRAYS_CACHE_SIZE);
+	}
+}
+
 // VGL_EXT_gpu_objects_array extension implementation
 
 void vglVertexPointer(GLint size, GLenum type, GLsizei stride, GLuint count, const GLvoid *pointer) {
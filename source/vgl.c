@@ -94,6 +94,7 @@ extern GLboolean use_vram_for_usse;
 uint16_t *default_idx_ptr; // sceGxm mapped progressive indices buffer
 uint16_t *default_quads_idx_ptr; // sceGxm mapped progressive indices buffer for quads
 uint16_t *default_line_strips_idx_ptr; // sceGxm mapped progressive indices buffer for line strips
+static uint32_t default_idx_num = 0; // Number of vertices addressable through the progressive indices buffers
 
 // Internal functions
 #ifdef HAVE_CIRCULAR_VERTEX_POOL
@@ -113,6 +114,64 @@ uint8_t *reserve_data_pool(uint32_t size) {
 }
 #endif
 
+uint32_t reserveDefaultIndices(uint32_t num) {
+	if (num <= default_idx_num)
+		return default_idx_num;
+
+	// Growing progressive indices buffers geometrically up to 16 bit addressing limit
+	uint32_t new_num = default_idx_num ? default_idx_num : MAX_IDX_NUMBER;
+	while (new_num < num) {
+		new_num *= 2;
+	}
+	if (new_num > MAX_DRAW_CHUNK_VERTICES)
+		new_num = MAX_DRAW_CHUNK_VERTICES;
+
+	uint16_t *idx_ptr = (uint16_t *)vglMalloc(new_num * sizeof(uint16_t));
+	uint16_t *quads_idx_ptr = (uint16_t *)vglMalloc((new_num / 4) * 6 * sizeof(uint16_t));
+	uint16_t *line_strips_idx_ptr = (uint16_t *)vglMalloc(new_num * 2 * sizeof(uint16_t));
+	if (!idx_ptr || !quads_idx_ptr || !line_strips_idx_ptr) {
+#ifdef LOG_ERRORS
+		vgl_log("%s:%d reserveDefaultIndices failed to grow progressive indices buffers to %u vertices.\n", __FILE__, __LINE__, new_num);
+#endif
+		// Keeping the current buffers, callers will clamp their draws to them
+		if (idx_ptr)
+			vglFree(idx_ptr);
+		if (quads_idx_ptr)
+			vglFree(quads_idx_ptr);
+		if (line_strips_idx_ptr)
+			vglFree(line_strips_idx_ptr);
+		return default_idx_num;
+	}
+	int i;
+	for (i = 0; i < new_num; i++) {
+		idx_ptr[i] = i;
+	}
+	for (i = 0; i < new_num - 1; i++) {
+		line_strips_idx_ptr[i * 2] = i;
+		line_strips_idx_ptr[i * 2 + 1] = i + 1;
+	}
+	for (i = 0; i < new_num / 4; i++) {
+		quads_idx_ptr[i * 6] = i * 4;
+		quads_idx_ptr[i * 6 + 1] = i * 4 + 1;
+		quads_idx_ptr[i * 6 + 2] = i * 4 + 3;
+		quads_idx_ptr[i * 6 + 3] = i * 4 + 1;
+		quads_idx_ptr[i * 6 + 4] = i * 4 + 2;
+		quads_idx_ptr[i * 6 + 5] = i * 4 + 3;
+	}
+
+	// Marking previous buffers for deletion since they may still be in use by the GPU
+	if (default_idx_num) {
+		markAsDirty(default_idx_ptr);
+		markAsDirty(default_quads_idx_ptr);
+		markAsDirty(default_line_strips_idx_ptr);
+	}
+	default_idx_ptr = idx_ptr;
+	default_quads_idx_ptr = quads_idx_ptr;
+	default_line_strips_idx_ptr = line_strips_idx_ptr;
+	default_idx_num = new_num;
+	return new_num;
+}
+
 void vector4f_convert_to_local_space(vector4f *out, int x, int y, int width, int height) {
 	out->x = (float)(2 * x) / DISPLAY_WIDTH_FLOAT - 1.0f;
 	out->y = (float)(2 * (x + width)) / DISPLAY_WIDTH_FLOAT - 1.0f;
@@ -304,29 +363,7 @@ GLboolean vglInitWithCustomSizes(int pool_size, int width, int height, int ram_p
 #endif
 
 	// Init constant index buffers
-	default_idx_ptr = (uint16_t *)vglMalloc(MAX_IDX_NUMBER * sizeof(uint16_t));
-	default_quads_idx_ptr = (uint16_t *)vglMalloc(MAX_IDX_NUMBER * sizeof(uint16_t));
-	default_line_strips_idx_ptr = (uint16_t *)vglMalloc(MAX_IDX_NUMBER * sizeof(uint16_t));
-	for (i = 0; i < MAX_IDX_NUMBER / 6; i++) {
-		default_idx_ptr[i * 6] = i * 6;
-		default_idx_ptr[i * 6 + 1] = i * 6 + 1;
-		default_idx_ptr[i * 6 + 2] = i * 6 + 2;
-		default_idx_ptr[i * 6 + 3] = i * 6 + 3;
-		default_idx_ptr[i * 6 + 4] = i * 6 + 4;
-		default_idx_ptr[i * 6 + 5] = i * 6 + 5;
-		default_line_strips_idx_ptr[i * 6] = i * 3;
-		default_line_strips_idx_ptr[i * 6 + 1] = i * 3 + 1;
-		default_line_strips_idx_ptr[i * 6 + 2] = i * 3 + 1;
-		default_line_strips_idx_ptr[i * 6 + 3] = i * 3 + 2;
-		default_line_strips_idx_ptr[i * 6 + 4] = i * 3 + 2;
-		default_line_strips_idx_ptr[i * 6 + 5] = i * 3 + 3;
-		default_quads_idx_ptr[i * 6] = i * 4;
-		default_quads_idx_ptr[i * 6 + 1] = i * 4 + 1;
-		default_quads_idx_ptr[i * 6 + 2] = i * 4 + 3;
-		default_quads_idx_ptr[i * 6 + 3] = i * 4 + 1;
-		default_quads_idx_ptr[i * 6 + 4] = i * 4 + 2;
-		default_quads_idx_ptr[i * 6 + 5] = i * 4 + 3;
-	}
+	reserveDefaultIndices(MAX_IDX_NUMBER);
 
 	// Init default vertex attributes configurations
 	for (i = 0; i < FFP_VERTEX_ATTRIBS_NUM; i++) {
@@ -437,25 +474,30 @@ GLboolean vglInitWithCustomSizes(int pool_size, int width, int height, int ram_p
 		frame_rt_purge_list[i][0] = NULL;
 	}
 
+	// Init worker threads utilities
+	vgl_init_jobs();
+
 	// Init scissor test state
 	resetScissorTestRegion();
 
 	// Allocating default texture object
-	texture_slots[0].mip_count = 1;
-	texture_slots[0].use_mips = GL_FALSE;
-	texture_slots[0].min_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
-	texture_slots[0].mag_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
-	texture_slots[0].mip_filter = SCE_GXM_TEXTURE_MIP_FILTER_DISABLED;
-	texture_slots[0].u_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
-	texture_slots[0].v_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
-	texture_slots[0].lod_bias = GL_MAX_TEXTURE_LOD_BIAS;
+	if (!allocTextureChunk(0)) {
+		vgl_log("%s:%d: Failed to allocate the default texture object.\n", __FILE__, __LINE__);
+		return GL_FALSE;
+	}
+	getTexture(0)->mip_count = 1;
+	getTexture(0)->use_mips = GL_FALSE;
+	getTexture(0)->min_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
+	getTexture(0)->mag_filter = SCE_GXM_TEXTURE_FILTER_LINEAR;
+	getTexture(0)->mip_filter = SCE_GXM_TEXTURE_MIP_FILTER_DISABLED;
+	getTexture(0)->u_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
+	getTexture(0)->v_mode = SCE_GXM_TEXTURE_ADDR_REPEAT;
+	getTexture(0)->lod_bias = GL_MAX_TEXTURE_LOD_BIAS;
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
-	// Defaulting textures into using texture on ID 0 and resetting free textures queue
-	for (i = 1; i < TEXTURES_NUM; i++) {
-		texture_slots[i].status = TEX_UNUSED;
-		texture_slots[i].gxm_tex = texture_slots[0].gxm_tex;
-		texture_slots[i].palette_data = NULL;
+	// Defaulting textures sharing the default texture slots chunk into using texture on ID 0, later chunks get it on allocation
+	for (i = 1; i < TEXTURES_CHUNK_SIZE; i++) {
+		getTexture(i)->gxm_tex = getTexture(0)->gxm_tex;
 	}
 
 	// Set texture matrix to identity
@@ -503,6 +545,9 @@ void vglEnd(void) {
 	// Wait for rendering to be finished
 	waitRenderingDone();
 
+	// Terminating timer queries thread
+	stopTimerQueries();
+
 	// Deallocating default vertices buffers
 	vglFree(clear_vertices);
 	vglFree(depth_vertices);
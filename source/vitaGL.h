@@ -304,6 +304,8 @@ extern "C" {
 #define GL_MAJOR_VERSION                                0x821B
 #define GL_MINOR_VERSION                                0x821C
 #define GL_NUM_EXTENSIONS                               0x821D
+#define GL_BUFFER_IMMUTABLE_STORAGE                     0x821F
+#define GL_BUFFER_STORAGE_FLAGS                         0x8220
 #define GL_RG                                           0x8227
 #define GL_UNSIGNED_SHORT_5_6_5                         0x8363
 #define GL_UNSIGNED_SHORT_1_5_5_5_REV                   0x8366
@@ -383,6 +385,10 @@ extern "C" {
 #define GL_BUFFER_SIZE                                  0x8764
 #define GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD              0x87EE
 #define GL_RGBA16F                                      0x881A
+#define GL_QUERY_COUNTER_BITS                           0x8864
+#define GL_CURRENT_QUERY                                0x8865
+#define GL_QUERY_RESULT                                 0x8866
+#define GL_QUERY_RESULT_AVAILABLE                       0x8867
 #define GL_MAX_VERTEX_ATTRIBS                           0x8869
 #define GL_VERTEX_ATTRIB_ARRAY_NORMALIZED               0x886A
 #define GL_MAX_TEXTURE_COORDS                           0x8871
@@ -395,6 +401,7 @@ extern "C" {
 #define GL_READ_ONLY                                    0x88B8
 #define GL_WRITE_ONLY                                   0x88B9
 #define GL_READ_WRITE                                   0x88BA
+#define GL_TIME_ELAPSED                                 0x88BF
 #define GL_STREAM_DRAW                                  0x88E0
 #define GL_STREAM_READ                                  0x88E1
 #define GL_STREAM_COPY                                  0x88E2
@@ -404,7 +411,10 @@ extern "C" {
 #define GL_DYNAMIC_DRAW                                 0x88E8
 #define GL_DYNAMIC_READ                                 0x88E9
 #define GL_DYNAMIC_COPY                                 0x88EA
+#define GL_PIXEL_UNPACK_BUFFER                          0x88EC
+#define GL_PIXEL_UNPACK_BUFFER_BINDING                  0x88EF
 #define GL_DEPTH24_STENCIL8                             0x88F0
+#define GL_SAMPLES_PASSED                               0x8914
 #define GL_FRAGMENT_SHADER                              0x8B30
 #define GL_VERTEX_SHADER                                0x8B31
 #define GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS               0x8B4C
@@ -444,6 +454,7 @@ extern "C" {
 #define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG              0x8C01
 #define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG             0x8C02
 #define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG             0x8C03
+#define GL_ANY_SAMPLES_PASSED                           0x8C2F
 #define GL_SRGB                                         0x8C40
 #define GL_SRGB8                                        0x8C41
 #define GL_SRGB_ALPHA                                   0x8C42
@@ -478,17 +489,32 @@ extern "C" {
 #define GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS             0x8B4D
 #define GL_HALF_FLOAT_OES                               0x8D61
 #define GL_ETC1_RGB8_OES                                0x8D64
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE              0x8D6A
 #define GL_SHADER_BINARY_FORMATS                        0x8DF8
 #define GL_NUM_SHADER_BINARY_FORMATS                    0x8DF9
 #define GL_SHADER_COMPILER                              0x8DFA
 #define GL_MAX_VERTEX_UNIFORM_VECTORS                   0x8DFB
 #define GL_MAX_VARYING_VECTORS                          0x8DFC
 #define GL_MAX_FRAGMENT_UNIFORM_VECTORS                 0x8DFD
+#define GL_TIMESTAMP                                    0x8E28
 #define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX         0x9047
 #define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX   0x9048
 #define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#define GL_OBJECT_TYPE                                  0x9112
+#define GL_SYNC_CONDITION                               0x9113
+#define GL_SYNC_STATUS                                  0x9114
+#define GL_SYNC_FLAGS                                   0x9115
+#define GL_SYNC_FENCE                                   0x9116
+#define GL_SYNC_GPU_COMMANDS_COMPLETE                   0x9117
+#define GL_UNSIGNALED                                   0x9118
+#define GL_SIGNALED                                     0x9119
+#define GL_ALREADY_SIGNALED                             0x911A
+#define GL_TIMEOUT_EXPIRED                              0x911B
+#define GL_CONDITION_SATISFIED                          0x911C
+#define GL_WAIT_FAILED                                  0x911D
 #define GL_COMPRESSED_RGBA_PVRTC_2BPPV2_IMG             0x9137
 #define GL_COMPRESSED_RGBA_PVRTC_4BPPV2_IMG             0x9138
+#define GL_QUERY_RESULT_NO_WAIT                         0x9194
 #define GL_COMPRESSED_RGBA8_ETC2_EAC                    0x9278
 
 #define EGL_SUCCESS                                  0x3000
@@ -524,6 +550,13 @@ extern "C" {
 #define GL_MAP_INVALIDATE_BUFFER_BIT      0x0008
 #define GL_MAP_FLUSH_EXPLICIT_BIT         0x0010
 #define GL_MAP_UNSYNCHRONIZED_BIT         0x0020
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#define GL_DYNAMIC_STORAGE_BIT            0x0100
+#define GL_CLIENT_STORAGE_BIT             0x0200
+
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#define GL_TIMEOUT_IGNORED                0xFFFFFFFFFFFFFFFFull
 
 // Aliases
 #define GL_DRAW_FRAMEBUFFER_BINDING GL_FRAMEBUFFER_BINDING
@@ -536,6 +569,7 @@ void glAlphaFunc(GLenum func, GLfloat ref);
 void glAlphaFuncx(GLenum func, GLfixed ref);
 void glAttachShader(GLuint prog, GLuint shad);
 void glBegin(GLenum mode);
+void glBeginQuery(GLenum target, GLuint id);
 void glBindAttribLocation(GLuint program, GLuint index, const GLchar *name);
 void glBindBuffer(GLenum target, GLuint buffer);
 void glBindFramebuffer(GLenum target, GLuint framebuffer);
@@ -547,6 +581,7 @@ void glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha);
 void glBlendFunc(GLenum sfactor, GLenum dfactor);
 void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
 void glBufferData(GLenum target, GLsizei size, const GLvoid *data, GLenum usage);
+void glBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
 void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 void glCallList(GLuint list);
 GLenum glCheckFramebufferStatus(GLenum target);
@@ -558,6 +593,7 @@ void glClearDepthf(GLclampf depth);
 void glClearDepthx(GLclampx depth);
 void glClearStencil(GLint s);
 void glClientActiveTexture(GLenum texture);
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
 void glClipPlane(GLenum plane, const GLdouble *equation);
 void glClipPlanef(GLenum plane, const GLfloat *equation);
 void glClipPlanex(GLenum plane, const GLfixed *equation);
@@ -583,8 +619,10 @@ void glDeleteBuffers(GLsizei n, const GLuint *gl_buffers);
 void glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers);
 void glDeleteLists(GLuint list, GLsizei range);
 void glDeleteProgram(GLuint prog);
+void glDeleteQueries(GLsizei n, const GLuint *ids);
 void glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers);
 void glDeleteShader(GLuint shad);
+void glDeleteSync(GLsync sync);
 void glDeleteTextures(GLsizei n, const GLuint *textures);
 void glDeleteVertexArrays(GLsizei n, const GLuint *gl_arrays);
 void glDepthFunc(GLenum func);
@@ -607,6 +645,8 @@ void glEnableClientState(GLenum array);
 void glEnableVertexAttribArray(GLuint index);
 void glEnd(void);
 void glEndList(void);
+void glEndQuery(GLenum target);
+GLsync glFenceSync(GLenum condition, GLbitfield flags);
 void glFinish(void);
 void glFlush(void);
 void glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length);
@@ -626,6 +666,7 @@ void glGenBuffers(GLsizei n, GLuint *buffers);
 void glGenerateMipmap(GLenum target);
 void glGenFramebuffers(GLsizei n, GLuint *framebuffers);
 GLuint glGenLists(GLsizei range);
+void glGenQueries(GLsizei n, GLuint *ids);
 void glGenRenderbuffers(GLsizei n, GLuint *renderbuffers);
 void glGenTextures(GLsizei n, GLuint *textures);
 void glGenVertexArrays(GLsizei n, GLuint *res);
@@ -635,6 +676,7 @@ void glGetAttachedShaders(GLuint prog, GLsizei maxCount, GLsizei *count, GLuint
 GLint glGetAttribLocation(GLuint prog, const GLchar *name);
 void glGetBooleanv(GLenum pname, GLboolean *params);
 void glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params);
+void glGetCompressedTexImage(GLenum target, GLint level, void *img);
 GLenum glGetError(void);
 void glGetFloatv(GLenum pname, GLfloat *data);
 void glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attachment, GLenum pname, GLint *params);
@@ -643,11 +685,16 @@ void glGetPointerv(GLenum pname, void **params);
 void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
 void glGetProgramInfoLog(GLuint program, GLsizei maxLength, GLsizei *length, GLchar *infoLog);
 void glGetProgramiv(GLuint program, GLenum pname, GLint *params);
+void glGetQueryiv(GLenum target, GLenum pname, GLint *params);
+void glGetQueryObjectiv(GLuint id, GLenum pname, GLint *params);
+void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params);
+void glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint *params);
 void glGetShaderInfoLog(GLuint handle, GLsizei maxLength, GLsizei *length, GLchar *infoLog);
 void glGetShaderiv(GLuint handle, GLenum pname, GLint *params);
 void glGetShaderSource(GLuint handle, GLsizei bufSize, GLsizei *length, GLchar *source);
 const GLubyte *glGetString(GLenum name);
 const GLubyte *glGetStringi(GLenum name, GLuint index);
+void glGetSynciv(GLsync sync, GLenum pname, GLsizei bufSize, GLsizei *length, GLint *values);
 void glGetTexEnviv(GLenum target, GLenum pname, GLint *params);
 GLint glGetUniformLocation(GLuint prog, const GLchar *name);
 void glGetVertexAttribfv(GLuint index, GLenum pname, GLfloat *params);
@@ -658,7 +705,9 @@ void glInterleavedArrays(GLenum format, GLsizei stride, const void *pointer);
 GLboolean glIsEnabled(GLenum cap);
 GLboolean glIsFramebuffer(GLuint fb);
 GLboolean glIsProgram(GLuint program);
+GLboolean glIsQuery(GLuint id);
 GLboolean glIsRenderbuffer(GLuint rb);
+GLboolean glIsSync(GLsync sync);
 GLboolean glIsTexture(GLuint texture);
 void glLightfv(GLenum light, GLenum pname, const GLfloat *params);
 void glLightModelfv(GLenum pname, const GLfloat *params);
@@ -704,6 +753,7 @@ void glPopMatrix(void);
 void glProgramBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
 void glPushAttrib(GLbitfield mask);
 void glPushMatrix(void);
+void glQueryCounter(GLuint id, GLenum target);
 void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *data);
 void glRectf(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2);
 void glReleaseShaderCompiler(void);
@@ -777,6 +827,7 @@ void glVertexAttrib4fv(GLuint index, const GLfloat *v);
 void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer);
 void glVertexPointer(GLint size, GLenum type, GLsizei stride, const GLvoid *pointer);
 void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void glWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
 
 // glu*
 void gluBuild2DMipmaps(GLenum target, GLint internalFormat, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *data);
@@ -812,6 +863,13 @@ void vglVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean nor
 void vglVertexAttribPointerMapped(GLuint index, const GLvoid *pointer);
 void vglGetShaderBinary(GLuint index, GLsizei bufSize, GLsizei *length, void *binary);
 
+// Precomputed draws for the vgl* draw pipeline with custom shaders
+GLuint vglBakeObjects(GLenum mode, GLsizei count, GLboolean implicit_wvp);
+void vglDeleteBakedObjects(GLuint objects);
+void vglDrawBakedObjects(GLuint objects);
+void vglEnableBakedObjectsQueue(GLboolean enable);
+void vglFlushBakedObjectsQueue(void);
+
 typedef enum {
 	VGL_MEM_VRAM, // CDRAM
 	VGL_MEM_RAM, // USER_RW RAM
@@ -830,6 +888,7 @@ void vglFree(void *addr);
 SceGxmTexture *vglGetGxmTexture(GLenum target);
 void *vglGetProcAddress(const char *name);
 void *vglGetTexDataPointer(GLenum target);
+GLint vglGetTexResidentLevel(GLenum target);
 GLboolean vglInit(int legacy_pool_size);
 GLboolean vglInitExtended(int legacy_pool_size, int width, int height, int ram_threshold, SceGxmMultisampleMode msaa);
 GLboolean vglInitWithCustomSizes(int legacy_pool_size, int width, int height, int ram_pool_size, int cdram_pool_size, int phycont_pool_size, int cdlg_pool_size, SceGxmMultisampleMode msaa);
@@ -841,9 +900,12 @@ size_t vglMemFree(vglMemType type);
 size_t vglMemTotal(vglMemType type);
 void vglOverloadTexDataPointer(GLenum target, void *data);
 void *vglRealloc(void *ptr, uint32_t size);
+void vglSetClientArraysCacheBudget(uint32_t size);
 void vglSetDisplayCallback(void (*cb)(void *framebuf));
 void vglSetFragmentBufferSize(uint32_t size);
 void vglSetParamBufferSize(uint32_t size);
+void vglSetTextureCache(const char *path, uint32_t max_size);
+void vglSetTextureUploadBudget(uint32_t bytes, uint32_t usecs);
 void vglSetUSSEBufferSize(uint32_t size);
 void vglSetVDMBufferSize(uint32_t size);
 void vglSetVertexBufferSize(uint32_t size);
@@ -852,6 +914,7 @@ void vglSetupGarbageCollector(int priority, int affinity);
 void vglSetupRuntimeShaderCompiler(shark_opt opt_level, int32_t use_fastmath, int32_t use_fastprecision, int32_t use_fastint);
 void vglSwapBuffers(GLboolean has_commondialog);
 void vglTexImageDepthBuffer(GLenum target);
+void vglTexMipStreaming(GLenum target, GLboolean enable, GLsizei width, GLsizei height);
 void vglUseCachedMem(GLboolean use);
 void vglUseTripleBuffering(GLboolean usage);
 void vglUseVram(GLboolean usage);